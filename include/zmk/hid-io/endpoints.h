@@ -6,8 +6,17 @@
 
 #pragma once
 
+#include <zephyr/kernel.h>
+
 #include <zmk/endpoints.h>
 
+int zmk_endpoints_send_report_alt(uint8_t report_id);
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+// Length of one report frame on the selected endpoint.
+k_timeout_t zmk_endpoints_frame_period_alt(void);
+#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
 int zmk_endpoints_send_joystick_report_alt();
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
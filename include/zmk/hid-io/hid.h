@@ -13,28 +13,30 @@
 #include <zmk/hid.h>
 #include <zmk/endpoints_types.h>
 
+#include <zmk/hid-io/report_format.h>
+
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
 #include <zmk/hid-io/joystick.h>
 #include <zmk/hid-io/hid_joystick.h>
-#define ZMK_HID_JOYSTICK_NUM_BUTTONS 0x08
-#define ZMK_HID_REPORT_ID__IO_JOYSTICK 0x02
+#define ZMK_HID_JOYSTICK_NUM_BUTTONS ZMK_HID_IO_JOYSTICK_BUTTONS
+#define ZMK_HID_REPORT_ID__IO_JOYSTICK ZMK_HID_IO_JOYSTICK_REPORT_ID
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
 #include <zmk/hid-io/mouse.h>
 #include <zmk/hid-io/hid_mouse.h>
-#define ZMK_HID_MOUSE_NUM_BUTTONS 0x05
-#define ZMK_HID_REPORT_ID__IO_MOUSE 0x03
+#define ZMK_HID_MOUSE_NUM_BUTTONS ZMK_HID_IO_MOUSE_BUTTONS
+#define ZMK_HID_REPORT_ID__IO_MOUSE ZMK_HID_IO_MOUSE_REPORT_ID
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_OUTPUT)
 #include <zmk/hid-io/hid_output.h>
-#define ZMK_HID_REPORT_ID__IO_OUTPUT 0x04
+#define ZMK_HID_REPORT_ID__IO_OUTPUT ZMK_HID_IO_OUTPUT_REPORT_ID
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_OUTPUT)
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
 #include <zmk/hid-io/hid_volume_knob.h>
-#define ZMK_HID_REPORT_ID__IO_VOLUME_KNOB 0x05
+#define ZMK_HID_REPORT_ID__IO_VOLUME_KNOB ZMK_HID_IO_VOLUME_KNOB_REPORT_ID
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
 
 #include <dt-bindings/zmk/hid_usage.h>
@@ -66,14 +68,21 @@ static const uint8_t zmk_hid_report_desc_alt[] = {
     HID_USAGE_PAGE(HID_USAGE_GEN_DESKTOP),
     HID_USAGE(HID_USAGE_GD_X),
     HID_USAGE(HID_USAGE_GD_Y),
+#if ZMK_HID_IO_JOYSTICK_AXES > 2
     HID_USAGE(HID_USAGE_GD_Z),
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 3
     HID_USAGE(HID_USAGE_GD_RX),
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 4
     HID_USAGE(HID_USAGE_GD_RY),
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 5
     HID_USAGE(HID_USAGE_GD_RZ),
-    HID_LOGICAL_MIN8(-0x7F),
-    HID_LOGICAL_MAX8(0x7F),
-    HID_REPORT_SIZE(0x08),
-    HID_REPORT_COUNT(0x06),
+#endif
+    ZMK_HID_IO_REL_RANGE(ZMK_HID_IO_JOYSTICK_AXIS_BITS),
+    HID_REPORT_SIZE(ZMK_HID_IO_JOYSTICK_AXIS_BITS),
+    HID_REPORT_COUNT(ZMK_HID_IO_JOYSTICK_AXES),
     HID_INPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_REL),
     HID_USAGE_PAGE(HID_USAGE_BUTTON),
     HID_USAGE_MIN8(0x1),
@@ -81,8 +90,14 @@ static const uint8_t zmk_hid_report_desc_alt[] = {
     HID_LOGICAL_MIN8(0x00),
     HID_LOGICAL_MAX8(0x01),
     HID_REPORT_SIZE(0x01),
-    HID_REPORT_COUNT(0x8),
+    HID_REPORT_COUNT(ZMK_HID_JOYSTICK_NUM_BUTTONS),
     HID_INPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_ABS),
+#if ZMK_HID_JOYSTICK_NUM_BUTTONS < 8
+    // Constant padding for the remaining bits of the button byte.
+    HID_REPORT_SIZE(8 - ZMK_HID_JOYSTICK_NUM_BUTTONS),
+    HID_REPORT_COUNT(0x01),
+    HID_INPUT(ZMK_HID_MAIN_VAL_CONST | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_ABS),
+#endif
     HID_END_COLLECTION,
     HID_END_COLLECTION,
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
@@ -100,27 +115,31 @@ static const uint8_t zmk_hid_report_desc_alt[] = {
     HID_LOGICAL_MIN8(0x00),
     HID_LOGICAL_MAX8(0x01),
     HID_REPORT_SIZE(0x01),
-    HID_REPORT_COUNT(0x5),
+    HID_REPORT_COUNT(ZMK_HID_MOUSE_NUM_BUTTONS),
     HID_INPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_ABS),
-    // Constant padding for the last 3 bits.
-    HID_REPORT_SIZE(0x03),
+#if ZMK_HID_MOUSE_NUM_BUTTONS < 8
+    // Constant padding for the remaining bits of the button byte.
+    HID_REPORT_SIZE(8 - ZMK_HID_MOUSE_NUM_BUTTONS),
     HID_REPORT_COUNT(0x01),
     HID_INPUT(ZMK_HID_MAIN_VAL_CONST | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_ABS),
+#endif
     // Some OSes ignore pointer devices without X/Y data.
     HID_USAGE_PAGE(HID_USAGE_GEN_DESKTOP),
     HID_USAGE(HID_USAGE_GD_X),
     HID_USAGE(HID_USAGE_GD_Y),
+    ZMK_HID_IO_REL_RANGE(ZMK_HID_IO_MOUSE_AXIS_BITS),
+    HID_REPORT_SIZE(ZMK_HID_IO_MOUSE_AXIS_BITS),
+    HID_REPORT_COUNT(0x02),
+    HID_INPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_REL),
     HID_USAGE(HID_USAGE_GD_WHEEL),
-    HID_LOGICAL_MIN16(0xFF, -0x7F),
-    HID_LOGICAL_MAX16(0xFF, 0x7F),
-    HID_REPORT_SIZE(0x10),
-    HID_REPORT_COUNT(0x03),
+    ZMK_HID_IO_REL_RANGE(ZMK_HID_IO_MOUSE_WHEEL_BITS),
+    HID_REPORT_SIZE(ZMK_HID_IO_MOUSE_WHEEL_BITS),
+    HID_REPORT_COUNT(0x01),
     HID_INPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_REL),
     HID_USAGE_PAGE(HID_USAGE_CONSUMER),
     HID_USAGE16_SINGLE(HID_USAGE_CONSUMER_AC_PAN),
-    HID_LOGICAL_MIN16(0xFF, -0x7F),
-    HID_LOGICAL_MAX16(0xFF, 0x7F),
-    HID_REPORT_SIZE(0x08),
+    ZMK_HID_IO_REL_RANGE(ZMK_HID_IO_MOUSE_WHEEL_BITS),
+    HID_REPORT_SIZE(ZMK_HID_IO_MOUSE_WHEEL_BITS),
     HID_REPORT_COUNT(0x01),
     HID_INPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_REL),
     HID_END_COLLECTION,
@@ -144,12 +163,12 @@ static const uint8_t zmk_hid_report_desc_alt[] = {
     HID_LOGICAL_MIN8(0),
     HID_LOGICAL_MAX8(100),
     HID_REPORT_COUNT(0x1),
-    HID_REPORT_SIZE(0x07),
-    HID_OUTPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_REL
+    HID_REPORT_SIZE(ZMK_HID_IO_VOLUME_KNOB_BODY_BITS),
+    HID_INPUT(ZMK_HID_MAIN_VAL_DATA | ZMK_HID_MAIN_VAL_VAR | ZMK_HID_MAIN_VAL_REL
              | ZMK_HID_MAIN_VAL_NO_WRAP | ZMK_HID_MAIN_VAL_LIN 
              | ZMK_HID_MAIN_VAL_NO_PREFERRED),
     HID_END_COLLECTION,
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_OUTPUT)
+#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
 
     // HID_END_COLLECTION,
 };
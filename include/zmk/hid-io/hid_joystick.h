@@ -13,14 +13,24 @@
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
 
 #include <zmk/hid-io/joystick.h>
+#include <zmk/hid-io/report_format.h>
 
+// Axes and field widths follow the zmk,hid-io devicetree node, see report_format.h.
 struct zmk_hid_joystick_report_body_alt {
-    int8_t d_x;
-    int8_t d_y;
-    int8_t d_z;
-    int8_t d_rx;
-    int8_t d_ry;
-    int8_t d_rz;
+    zmk_hid_io_joystick_axis_t d_x;
+    zmk_hid_io_joystick_axis_t d_y;
+#if ZMK_HID_IO_JOYSTICK_AXES > 2
+    zmk_hid_io_joystick_axis_t d_z;
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 3
+    zmk_hid_io_joystick_axis_t d_rx;
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 4
+    zmk_hid_io_joystick_axis_t d_ry;
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 5
+    zmk_hid_io_joystick_axis_t d_rz;
+#endif
     zmk_joystick_button_flags_t buttons;
 } __packed;
 struct zmk_hid_joystick_report_alt {
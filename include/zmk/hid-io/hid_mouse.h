@@ -13,13 +13,15 @@
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
 
 #include <zmk/hid-io/mouse.h>
+#include <zmk/hid-io/report_format.h>
 
+// Field widths follow the zmk,hid-io devicetree node, see report_format.h.
 struct zmk_hid_mouse_report_body_alt {
     zmk_mouse_button_flags_t buttons;
-    int16_t d_x;
-    int16_t d_y;
-    int16_t d_scroll_y;
-    int16_t d_scroll_x;
+    zmk_hid_io_mouse_axis_t d_x;
+    zmk_hid_io_mouse_axis_t d_y;
+    zmk_hid_io_mouse_wheel_t d_scroll_y;
+    zmk_hid_io_mouse_wheel_t d_scroll_x;
 } __packed;
 struct zmk_hid_mouse_report_alt {
     uint8_t report_id;
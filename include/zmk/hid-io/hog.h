@@ -10,15 +10,14 @@
 #include <zmk/hid.h>
 
 #include <zmk/hid-io/hid.h>
+#include <zmk/hid-io/report.h>
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-int zmk_hog_send_joystick_report_alt(struct zmk_hid_joystick_report_body_alt *body);
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+bool zmk_hog_report_subscribed_alt(const struct zmk_hid_io_report_def *def);
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-int zmk_hog_send_mouse_report_alt(struct zmk_hid_mouse_report_body_alt *body);
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+int zmk_hog_send_report_alt(const struct zmk_hid_io_report_def *def);
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-int zmk_hog_send_volume_knob_report_alt(struct zmk_hid_volume_knob_report_body_alt *body);
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+// Drop the reports queued for notification and not handed to the stack yet.
+void zmk_hog_discard_reports_alt(void);
+
+// Connection interval of the active profile in microseconds, or 0 if not connected.
+uint32_t zmk_hog_conn_interval_us_alt(void);
@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/bluetooth/conn.h>
+
+/*
+ * Note HID I/O reports being sent on `conn`. The first call after an idle period requests
+ * a fast link; the link is relaxed back once no report was sent for the idle time.
+ */
+void zmk_hid_io_link_activity(struct bt_conn *conn);
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct bt_conn;
+
+// Connection parameters, in the units of an LE connection parameter update.
+struct zmk_hid_io_link_param {
+    uint16_t interval;
+    uint16_t latency;
+    uint16_t timeout;
+};
+
+/*
+ * State of the link manager without the Bluetooth calls: the connection a fast link was
+ * requested for, and the parameters to go back to once idle. Callers serialise access and
+ * own the connection references.
+ */
+struct zmk_hid_io_link_state {
+    struct bt_conn *conn;
+    // idle_param is valid
+    bool restore;
+    struct zmk_hid_io_link_param idle_param;
+};
+
+// True if a link with this connection interval, in 1.25 ms units, is slower than requested.
+bool zmk_hid_io_link_is_slow(uint16_t interval);
+
+/*
+ * Note activity on `conn`. Returns true if it is not the tracked connection: it is then
+ * tracked instead, the previous one is stored in `old`, and a fast link should be
+ * requested.
+ */
+bool zmk_hid_io_link_state_activity(struct zmk_hid_io_link_state *state, struct bt_conn *conn,
+                                    struct bt_conn **old);
+
+// A fast link was granted to `conn`, which had `param` before. Ignored if no longer tracked.
+void zmk_hid_io_link_state_boosted(struct zmk_hid_io_link_state *state, struct bt_conn *conn,
+                                   const struct zmk_hid_io_link_param *param);
+
+/*
+ * The link went idle. Returns the tracked connection, which is no longer tracked, or NULL.
+ * `restore` tells whether `param` should be requested for it again.
+ */
+struct bt_conn *zmk_hid_io_link_state_idle(struct zmk_hid_io_link_state *state, bool *restore,
+                                           struct zmk_hid_io_link_param *param);
+
+// `conn` disconnected. Returns it if it was tracked, so the caller can release it.
+struct bt_conn *zmk_hid_io_link_state_disconnected(struct zmk_hid_io_link_state *state,
+                                                   struct bt_conn *conn);
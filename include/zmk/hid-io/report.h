@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+
+#include <zmk/hid-io/hid.h>
+
+/*
+ * Compile-time registry of the HID I/O input reports. Each usage contributes one
+ * zmk_hid_io_report_def; the USB, HOG and endpoint layers dispatch through it by report
+ * ID or by dense index instead of carrying per-usage copies of the send path.
+ */
+
+enum zmk_hid_io_report_policy {
+    // every report is delivered in order
+    ZMK_HID_IO_REPORT_POLICY_FIFO,
+    // relative motion; consecutive reports may be merged while `mergeable` holds
+    ZMK_HID_IO_REPORT_POLICY_RELATIVE,
+    // absolute state; a single slot that a newer report overwrites
+    ZMK_HID_IO_REPORT_POLICY_LATEST,
+};
+
+enum zmk_hid_io_report_index {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    ZMK_HID_IO_REPORT_JOYSTICK,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    ZMK_HID_IO_REPORT_MOUSE,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+    ZMK_HID_IO_REPORT_VOLUME_KNOB,
+#endif
+    ZMK_HID_IO_REPORT_COUNT,
+};
+
+union zmk_hid_io_report_any {
+    uint8_t report_id;
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    struct zmk_hid_joystick_report_alt joystick;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    struct zmk_hid_mouse_report_alt mouse;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+    struct zmk_hid_volume_knob_report_alt volume_knob;
+#endif
+};
+
+// Largest report, including the leading report ID byte.
+#define ZMK_HID_IO_REPORT_MAX_SIZE sizeof(union zmk_hid_io_report_any)
+
+/*
+ * Copy of a report published for readers that must not take the report lock (USB
+ * GET_REPORT, GATT reads). A sequence counter that is odd while the copy is being written
+ * lets readers detect a torn read and retry. The copy is written with interrupts locked, so
+ * a reader never has to wait on a preempted writer.
+ */
+struct zmk_hid_io_report_snapshot {
+    atomic_t seq;
+    union zmk_hid_io_report_any report;
+};
+
+#define ZMK_HID_IO_REPORT_SNAPSHOT_INIT(_id)                                                       \
+    { .report = {.report_id = (_id)} }
+
+struct zmk_hid_io_report_def {
+    uint8_t id;
+    enum zmk_hid_io_report_index index;
+    enum zmk_hid_io_report_policy policy;
+    // live report, starting with the report ID byte
+    uint8_t *report;
+    size_t body_size;
+    // RELATIVE only: true if both bodies carry the same button state
+    bool (*mergeable)(const void *body, const void *next);
+    // RELATIVE only: add the motion of `next` into `body`, saturating each axis
+    void (*merge)(void *body, const void *next);
+    // RELATIVE only: true if the body carries no motion
+    bool (*idle)(const void *body);
+    // body of the last report handed to a transport
+    uint8_t *last_sent;
+    // last published state of the report
+    struct zmk_hid_io_report_snapshot *snapshot;
+};
+
+#define ZMK_HID_IO_REPORT_SIZE(def) ((def)->body_size + 1)
+#define ZMK_HID_IO_REPORT_BODY(def) ((def)->report + 1)
+
+extern const struct zmk_hid_io_report_def *const zmk_hid_io_reports[ZMK_HID_IO_REPORT_COUNT];
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+extern const struct zmk_hid_io_report_def zmk_hid_io_report_def_joystick;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+extern const struct zmk_hid_io_report_def zmk_hid_io_report_def_mouse;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+extern const struct zmk_hid_io_report_def zmk_hid_io_report_def_volume_knob;
+#endif
+
+// Returns the registered input report with the given ID, or NULL.
+const struct zmk_hid_io_report_def *zmk_hid_io_report_get(uint8_t report_id);
+
+/*
+ * True if the live report is worth sending: it differs from the last sent one, or it
+ * carries relative motion. After motion, this yields exactly one terminating idle report.
+ */
+bool zmk_hid_io_report_changed(const struct zmk_hid_io_report_def *def);
+
+void zmk_hid_io_report_mark_sent(const struct zmk_hid_io_report_def *def);
+
+/*
+ * Publish the live report as the state seen by readers. Must be called with the report
+ * lock held, once the report is settled (motion of a relative report already sent).
+ */
+void zmk_hid_io_report_publish(const struct zmk_hid_io_report_def *def);
+
+// Copy the last published report, including the report ID byte. Lock-free.
+void zmk_hid_io_report_read(const struct zmk_hid_io_report_def *def, void *report);
+
+/*
+ * Guards the live reports and the transport they are sent on: held while a report is
+ * updated and sent, and while the selected endpoint changes. Recursive.
+ */
+void zmk_hid_io_report_lock(void);
+void zmk_hid_io_report_unlock(void);
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <zephyr/devicetree.h>
+#include <zephyr/sys/util.h>
+
+/*
+ * Layout of the HID I/O reports, from the node selected by the `zmk,hid-io` chosen
+ * property (see dts/bindings/zmk,hid-io.yaml). The report descriptor and the report
+ * structs are both built from these values, and each usage asserts that its struct has
+ * the size the descriptor declares.
+ */
+
+#if DT_HAS_CHOSEN(zmk_hid_io)
+#define ZMK_HID_IO_CFG(prop, default_value) DT_PROP_OR(DT_CHOSEN(zmk_hid_io), prop, default_value)
+#else
+#define ZMK_HID_IO_CFG(prop, default_value) default_value
+#endif
+
+#define ZMK_HID_IO_JOYSTICK_REPORT_ID ZMK_HID_IO_CFG(joystick_report_id, 2)
+#define ZMK_HID_IO_MOUSE_REPORT_ID ZMK_HID_IO_CFG(mouse_report_id, 3)
+#define ZMK_HID_IO_OUTPUT_REPORT_ID ZMK_HID_IO_CFG(output_report_id, 4)
+#define ZMK_HID_IO_VOLUME_KNOB_REPORT_ID ZMK_HID_IO_CFG(volume_knob_report_id, 5)
+
+#define ZMK_HID_IO_JOYSTICK_BUTTONS ZMK_HID_IO_CFG(joystick_buttons, 8)
+#define ZMK_HID_IO_JOYSTICK_AXES ZMK_HID_IO_CFG(joystick_axes, 6)
+#define ZMK_HID_IO_JOYSTICK_AXIS_BITS ZMK_HID_IO_CFG(joystick_axis_bits, 8)
+
+#define ZMK_HID_IO_MOUSE_BUTTONS ZMK_HID_IO_CFG(mouse_buttons, 5)
+#define ZMK_HID_IO_MOUSE_AXIS_BITS ZMK_HID_IO_CFG(mouse_axis_bits, 16)
+#define ZMK_HID_IO_MOUSE_WHEEL_BITS ZMK_HID_IO_CFG(mouse_wheel_bits, 16)
+
+#if ZMK_HID_IO_JOYSTICK_BUTTONS < 1 || ZMK_HID_IO_JOYSTICK_BUTTONS > 8
+#error "zmk,hid-io: joystick-buttons must be 1 to 8"
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES < 2 || ZMK_HID_IO_JOYSTICK_AXES > 6
+#error "zmk,hid-io: joystick-axes must be 2 to 6"
+#endif
+#if ZMK_HID_IO_MOUSE_BUTTONS < 1 || ZMK_HID_IO_MOUSE_BUTTONS > 8
+#error "zmk,hid-io: mouse-buttons must be 1 to 8"
+#endif
+
+// Field type, largest magnitude and descriptor logical range of a signed relative field.
+#define ZMK_HID_IO_REL_T_8 int8_t
+#define ZMK_HID_IO_REL_T_16 int16_t
+#define ZMK_HID_IO_REL_MAX_8 0x7F
+#define ZMK_HID_IO_REL_MAX_16 0x7FFF
+#define ZMK_HID_IO_REL_RANGE_8 HID_LOGICAL_MIN8(-0x7F), HID_LOGICAL_MAX8(0x7F)
+#define ZMK_HID_IO_REL_RANGE_16 HID_LOGICAL_MIN16(0x01, 0x80), HID_LOGICAL_MAX16(0xFF, 0x7F)
+
+#define ZMK_HID_IO_REL_T(bits) UTIL_CAT(ZMK_HID_IO_REL_T_, bits)
+#define ZMK_HID_IO_REL_MAX(bits) UTIL_CAT(ZMK_HID_IO_REL_MAX_, bits)
+#define ZMK_HID_IO_REL_RANGE(bits) UTIL_CAT(ZMK_HID_IO_REL_RANGE_, bits)
+
+typedef ZMK_HID_IO_REL_T(ZMK_HID_IO_JOYSTICK_AXIS_BITS) zmk_hid_io_joystick_axis_t;
+typedef ZMK_HID_IO_REL_T(ZMK_HID_IO_MOUSE_AXIS_BITS) zmk_hid_io_mouse_axis_t;
+typedef ZMK_HID_IO_REL_T(ZMK_HID_IO_MOUSE_WHEEL_BITS) zmk_hid_io_mouse_wheel_t;
+
+#define ZMK_HID_IO_JOYSTICK_AXIS_MAX ZMK_HID_IO_REL_MAX(ZMK_HID_IO_JOYSTICK_AXIS_BITS)
+#define ZMK_HID_IO_MOUSE_AXIS_MAX ZMK_HID_IO_REL_MAX(ZMK_HID_IO_MOUSE_AXIS_BITS)
+#define ZMK_HID_IO_MOUSE_WHEEL_MAX ZMK_HID_IO_REL_MAX(ZMK_HID_IO_MOUSE_WHEEL_BITS)
+
+// Body sizes in bits as declared by the report descriptor; buttons are padded to a byte.
+#define ZMK_HID_IO_JOYSTICK_BODY_BITS                                                              \
+    (ZMK_HID_IO_JOYSTICK_AXES * ZMK_HID_IO_JOYSTICK_AXIS_BITS + 8)
+#define ZMK_HID_IO_MOUSE_BODY_BITS                                                                 \
+    (8 + 2 * ZMK_HID_IO_MOUSE_AXIS_BITS + 2 * ZMK_HID_IO_MOUSE_WHEEL_BITS)
+#define ZMK_HID_IO_VOLUME_KNOB_BODY_BITS 8
+
+// Highest input report ID in use, bounds the by-ID lookup table.
+#define ZMK_HID_IO_REPORT_ID_MAX                                                                   \
+    MAX(MAX(ZMK_HID_IO_JOYSTICK_REPORT_ID, ZMK_HID_IO_MOUSE_REPORT_ID),                            \
+        MAX(ZMK_HID_IO_OUTPUT_REPORT_ID, ZMK_HID_IO_VOLUME_KNOB_REPORT_ID))
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+
+#include <zmk/hid-io/report.h>
+
+/*
+ * An input source feeding one HID I/O report, e.g. one forwarder instance. Each source
+ * keeps its own contribution slot; the contributions of all sources of a report are
+ * merged into a single report per send cycle, and each source only releases the buttons
+ * it pressed itself.
+ */
+struct zmk_hid_io_source {
+    sys_snode_t node;
+    const struct zmk_hid_io_report_def *def;
+    // buttons currently held by this source
+    uint32_t buttons;
+    // button transitions not yet applied to the report
+    uint32_t press;
+    uint32_t release;
+    // relative motion not yet sent
+    int32_t x;
+    int32_t y;
+    int32_t scroll_x;
+    int32_t scroll_y;
+    // latest absolute value not yet sent
+    bool abs_pending;
+    int16_t abs_x;
+    int16_t abs_y;
+    bool pending;
+};
+
+struct zmk_hid_io_contribution {
+    // x/y carry relative motion, or an absolute position
+    bool rel;
+    bool abs;
+    int16_t x;
+    int16_t y;
+    bool scroll;
+    int16_t scroll_x;
+    int16_t scroll_y;
+    uint32_t button_set;
+    uint32_t button_clear;
+};
+
+// Register a source for the report with the given ID. Sources for unknown IDs are ignored.
+void zmk_hid_io_source_init(struct zmk_hid_io_source *src, uint8_t report_id);
+
+// Add a contribution to the source's slot and schedule a send cycle for its report.
+int zmk_hid_io_source_contribute(struct zmk_hid_io_source *src,
+                                 const struct zmk_hid_io_contribution *contrib);
@@ -8,14 +8,9 @@
 
 #include <stdint.h>
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-int zmk_usb_hid_send_joystick_report_alt(void);
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+#include <zmk/hid-io/report.h>
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-int zmk_usb_hid_send_mouse_report_alt(void);
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+int zmk_usb_hid_send_report_alt(const struct zmk_hid_io_report_def *def);
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-int zmk_usb_hid_send_volume_knob_report_alt(void);
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+// Drop the reports held for sending and not written to the IN endpoint yet.
+void zmk_usb_hid_discard_reports_alt(void);
@@ -21,6 +21,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #if IS_ENABLED(CONFIG_ZMK_HID_IO)
 #include <zmk/hid-io/endpoints.h>
 #include <zmk/hid-io/hid.h>
+#include <zmk/hid-io/source.h>
 #endif
 
 // #if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
@@ -59,26 +60,52 @@ struct behavior_fwd_to_hid_io_data {
             uint8_t button_clear;
         } fwdr;
     };
+#if IS_ENABLED(CONFIG_ZMK_HID_IO)
+    struct zmk_hid_io_source source;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    // guards fwdr against the frame work
+    struct k_mutex lock;
+    struct k_work_delayable frame_work;
+    bool frame_pending;
+#endif
 };
 
+#if IS_ENABLED(CONFIG_ZMK_HID_IO)
+static uint8_t fwd_usage_report_id(int usage) {
+    switch (usage) {
+    case HID_IO_USAGE_FWD_TO_MOUSE:
+        return ZMK_HID_IO_MOUSE_REPORT_ID;
+    case HID_IO_USAGE_FWD_TO_JOYSTICK:
+        return ZMK_HID_IO_JOYSTICK_REPORT_ID;
+    case HID_IO_USAGE_FWD_TO_VOLUME_KNOB:
+        return ZMK_HID_IO_VOLUME_KNOB_REPORT_ID;
+    default:
+        return 0;
+    }
+}
+#endif
+
 static void handle_rel_code(const struct behavior_fwd_to_hid_io_config *config,
                             struct behavior_fwd_to_hid_io_data *data, struct input_event *evt) {
     switch (evt->code) {
     case INPUT_REL_X:
         data->fwdr.data.mode = HID_IO_XY_DATA_MODE_REL;
-        data->fwdr.data.x += evt->value;
+        data->fwdr.data.x = CLAMP(data->fwdr.data.x + evt->value, INT16_MIN, INT16_MAX);
         break;
     case INPUT_REL_Y:
         data->fwdr.data.mode = HID_IO_XY_DATA_MODE_REL;
-        data->fwdr.data.y += evt->value;
+        data->fwdr.data.y = CLAMP(data->fwdr.data.y + evt->value, INT16_MIN, INT16_MAX);
         break;
     case INPUT_REL_WHEEL:
         data->fwdr.wheel_data.mode = HID_IO_XY_DATA_MODE_REL;
-        data->fwdr.wheel_data.y += evt->value;
+        data->fwdr.wheel_data.y =
+            CLAMP(data->fwdr.wheel_data.y + evt->value, INT16_MIN, INT16_MAX);
         break;
     case INPUT_REL_HWHEEL:
         data->fwdr.wheel_data.mode = HID_IO_XY_DATA_MODE_REL;
-        data->fwdr.wheel_data.x += evt->value;
+        data->fwdr.wheel_data.x =
+            CLAMP(data->fwdr.wheel_data.x + evt->value, INT16_MIN, INT16_MAX);
         break;
     default:
         break;
@@ -128,6 +155,62 @@ static void clear_xy_data(struct fwd_to_hid_io_xy_data *data) {
     data->mode = HID_IO_XY_DATA_MODE_NONE;
 }
 
+static void fwd_send_frame(const struct behavior_fwd_to_hid_io_config *config,
+                           struct behavior_fwd_to_hid_io_data *data) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO)
+    struct zmk_hid_io_contribution contrib = {
+        .rel = data->fwdr.data.mode == HID_IO_XY_DATA_MODE_REL,
+        .abs = data->fwdr.data.mode == HID_IO_XY_DATA_MODE_ABS,
+        .x = data->fwdr.data.x,
+        .y = data->fwdr.data.y,
+        .scroll = data->fwdr.wheel_data.mode == HID_IO_XY_DATA_MODE_REL,
+        .scroll_x = data->fwdr.wheel_data.x,
+        .scroll_y = data->fwdr.wheel_data.y,
+        .button_set = data->fwdr.button_set,
+        .button_clear = data->fwdr.button_clear,
+    };
+    zmk_hid_io_source_contribute(&data->source, &contrib);
+#endif
+
+    clear_xy_data(&data->fwdr.data);
+    clear_xy_data(&data->fwdr.wheel_data);
+
+    data->fwdr.button_set = data->fwdr.button_clear = 0;
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    data->frame_pending = false;
+#endif
+}
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+static void fwd_frame_work_cb(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct behavior_fwd_to_hid_io_data *data =
+        CONTAINER_OF(dwork, struct behavior_fwd_to_hid_io_data, frame_work);
+
+    k_mutex_lock(&data->lock, K_FOREVER);
+    if (data->frame_pending) {
+        fwd_send_frame(data->dev->config, data);
+    }
+    k_mutex_unlock(&data->lock);
+}
+#endif
+
+static void fwd_sync(const struct behavior_fwd_to_hid_io_config *config,
+                     struct behavior_fwd_to_hid_io_data *data) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    // button changes go out at once, so a press and release within one frame are not lost
+    if (data->fwdr.button_set == 0 && data->fwdr.button_clear == 0) {
+        data->frame_pending = true;
+        if (!k_work_delayable_is_pending(&data->frame_work)) {
+            k_work_schedule(&data->frame_work, zmk_endpoints_frame_period_alt());
+        }
+        return;
+    }
+#endif
+    fwd_send_frame(config, data);
+}
+
 static int to_keymap_binding_pressed(struct zmk_behavior_binding *binding,
                                      struct zmk_behavior_binding_event event) {
 
@@ -138,6 +221,10 @@ static int to_keymap_binding_pressed(struct zmk_behavior_binding *binding,
     
     struct input_event *evt = (struct input_event *)event.position;
 
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    k_mutex_lock(&data->lock, K_FOREVER);
+#endif
+
     switch (evt->type) {
     case INPUT_EV_REL:
         handle_rel_code(config, data, evt);
@@ -151,84 +238,27 @@ static int to_keymap_binding_pressed(struct zmk_behavior_binding *binding,
     }
 
     if (evt->sync) {
+        fwd_sync(config, data);
+    }
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO)
-
-    #if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-        if (config->usage == HID_IO_USAGE_FWD_TO_JOYSTICK) {
-            if (data->fwdr.data.mode == HID_IO_XY_DATA_MODE_REL) {
-                zmk_hid_joy2_movement_set(data->fwdr.data.x, data->fwdr.data.y);
-            }
-            if (data->fwdr.button_set != 0) {
-                for (int i = 0; i < ZMK_HID_JOYSTICK_NUM_BUTTONS; i++) {
-                    if ((data->fwdr.button_set & BIT(i)) != 0) {
-                        zmk_hid_joy2_button_press(i);
-                    }
-                }
-            }
-            if (data->fwdr.button_clear != 0) {
-                for (int i = 0; i < ZMK_HID_JOYSTICK_NUM_BUTTONS; i++) {
-                    if ((data->fwdr.button_clear & BIT(i)) != 0) {
-                        zmk_hid_joy2_button_release(i);
-                    }
-                }
-            }
-            zmk_endpoints_send_joystick_report_alt();
-            zmk_hid_joy2_movement_set(0, 0);
-        }
-    #endif
-
-    #if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-        if (config->usage == HID_IO_USAGE_FWD_TO_MOUSE) {
-            if (data->fwdr.wheel_data.mode == HID_IO_XY_DATA_MODE_REL) {
-                zmk_hid_mou2_scroll_set(data->fwdr.wheel_data.x, data->fwdr.wheel_data.y);
-            }
-            if (data->fwdr.data.mode == HID_IO_XY_DATA_MODE_REL) {
-                zmk_hid_mou2_movement_set(data->fwdr.data.x, data->fwdr.data.y);
-            }
-            if (data->fwdr.button_set != 0) {
-                for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                    if ((data->fwdr.button_set & BIT(i)) != 0) {
-                        zmk_hid_mou2_button_press(i);
-                    }
-                }
-            }
-            if (data->fwdr.button_clear != 0) {
-                for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                    if ((data->fwdr.button_clear & BIT(i)) != 0) {
-                        zmk_hid_mou2_button_release(i);
-                    }
-                }
-            }
-            zmk_endpoints_send_mouse_report_alt();
-            zmk_hid_mou2_scroll_set(0, 0);
-            zmk_hid_mou2_movement_set(0, 0);
-        }
-    #endif
-
-    #if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-        if (config->usage == HID_IO_USAGE_FWD_TO_VOLUME_KNOB) {
-            if (data->fwdr.data.mode == HID_IO_XY_DATA_MODE_ABS) {
-                zmk_hid_volume_knob_vol_set(data->fwdr.data.y);
-            }
-            zmk_endpoints_send_volume_knob_report_alt();
-        }
-    #endif
-
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    k_mutex_unlock(&data->lock);
 #endif
 
-        clear_xy_data(&data->fwdr.data);
-        clear_xy_data(&data->fwdr.wheel_data);
-
-        data->fwdr.button_set = data->fwdr.button_clear = 0;
-    }
-
     return ZMK_BEHAVIOR_OPAQUE;
 }
 
 static int input_behavior_to_init(const struct device *dev) {
     struct behavior_fwd_to_hid_io_data *data = dev->data;
     data->dev = dev;
+#if IS_ENABLED(CONFIG_ZMK_HID_IO)
+    const struct behavior_fwd_to_hid_io_config *config = dev->config;
+    zmk_hid_io_source_init(&data->source, fwd_usage_report_id(config->usage));
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    k_mutex_init(&data->lock);
+    k_work_init_delayable(&data->frame_work, fwd_frame_work_cb);
+#endif
     return 0;
 };
 
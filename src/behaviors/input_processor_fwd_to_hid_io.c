@@ -22,6 +22,7 @@ LOG_MODULE_DECLARE(zmk, CONFIG_ZMK_LOG_LEVEL);
 #if IS_ENABLED(CONFIG_ZMK_HID_IO)
 #include <zmk/hid-io/endpoints.h>
 #include <zmk/hid-io/hid.h>
+#include <zmk/hid-io/source.h>
 #endif
 
 // #if DT_HAS_COMPAT_STATUS_OKAY(DT_DRV_COMPAT)
@@ -60,26 +61,52 @@ struct zip_fwd_to_hid_io_data {
             uint8_t button_clear;
         } fwdr;
     };
+#if IS_ENABLED(CONFIG_ZMK_HID_IO)
+    struct zmk_hid_io_source source;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    // guards fwdr against the frame work
+    struct k_mutex lock;
+    struct k_work_delayable frame_work;
+    bool frame_pending;
+#endif
 };
 
+#if IS_ENABLED(CONFIG_ZMK_HID_IO)
+static uint8_t zip_usage_report_id(int usage) {
+    switch (usage) {
+    case ZIP_HID_IO_USAGE_FWD_TO_MOUSE:
+        return ZMK_HID_IO_MOUSE_REPORT_ID;
+    case ZIP_HID_IO_USAGE_FWD_TO_JOYSTICK:
+        return ZMK_HID_IO_JOYSTICK_REPORT_ID;
+    case ZIP_HID_IO_USAGE_FWD_TO_VOLUME_KNOB:
+        return ZMK_HID_IO_VOLUME_KNOB_REPORT_ID;
+    default:
+        return 0;
+    }
+}
+#endif
+
 static void handle_rel_code(const struct zip_fwd_to_hid_io_config *config,
                             struct zip_fwd_to_hid_io_data *data, struct input_event *event) {
     switch (event->code) {
     case INPUT_REL_X:
         data->fwdr.data.mode = HID_IO_XY_DATA_MODE_REL;
-        data->fwdr.data.x += event->value;
+        data->fwdr.data.x = CLAMP(data->fwdr.data.x + event->value, INT16_MIN, INT16_MAX);
         break;
     case INPUT_REL_Y:
         data->fwdr.data.mode = HID_IO_XY_DATA_MODE_REL;
-        data->fwdr.data.y += event->value;
+        data->fwdr.data.y = CLAMP(data->fwdr.data.y + event->value, INT16_MIN, INT16_MAX);
         break;
     case INPUT_REL_WHEEL:
         data->fwdr.wheel_data.mode = HID_IO_XY_DATA_MODE_REL;
-        data->fwdr.wheel_data.y += event->value;
+        data->fwdr.wheel_data.y =
+            CLAMP(data->fwdr.wheel_data.y + event->value, INT16_MIN, INT16_MAX);
         break;
     case INPUT_REL_HWHEEL:
         data->fwdr.wheel_data.mode = HID_IO_XY_DATA_MODE_REL;
-        data->fwdr.wheel_data.x += event->value;
+        data->fwdr.wheel_data.x =
+            CLAMP(data->fwdr.wheel_data.x + event->value, INT16_MIN, INT16_MAX);
         break;
     default:
         break;
@@ -129,12 +156,72 @@ static void clear_xy_data(struct zip_fwd_to_hid_io_xy_data *data) {
     data->mode = HID_IO_XY_DATA_MODE_NONE;
 }
 
+static void zip_send_frame(const struct zip_fwd_to_hid_io_config *config,
+                           struct zip_fwd_to_hid_io_data *data) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO)
+    struct zmk_hid_io_contribution contrib = {
+        .rel = data->fwdr.data.mode == HID_IO_XY_DATA_MODE_REL,
+        .abs = data->fwdr.data.mode == HID_IO_XY_DATA_MODE_ABS,
+        .x = data->fwdr.data.x,
+        .y = data->fwdr.data.y,
+        .scroll = data->fwdr.wheel_data.mode == HID_IO_XY_DATA_MODE_REL,
+        .scroll_x = data->fwdr.wheel_data.x,
+        .scroll_y = data->fwdr.wheel_data.y,
+        .button_set = data->fwdr.button_set,
+        .button_clear = data->fwdr.button_clear,
+    };
+    zmk_hid_io_source_contribute(&data->source, &contrib);
+#endif
+
+    clear_xy_data(&data->fwdr.data);
+    clear_xy_data(&data->fwdr.wheel_data);
+
+    data->fwdr.button_set = data->fwdr.button_clear = 0;
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    data->frame_pending = false;
+#endif
+}
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+static void zip_frame_work_cb(struct k_work *work) {
+    struct k_work_delayable *dwork = k_work_delayable_from_work(work);
+    struct zip_fwd_to_hid_io_data *data =
+        CONTAINER_OF(dwork, struct zip_fwd_to_hid_io_data, frame_work);
+
+    k_mutex_lock(&data->lock, K_FOREVER);
+    if (data->frame_pending) {
+        zip_send_frame(data->dev->config, data);
+    }
+    k_mutex_unlock(&data->lock);
+}
+#endif
+
+static void zip_sync(const struct zip_fwd_to_hid_io_config *config,
+                     struct zip_fwd_to_hid_io_data *data) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    // button changes go out at once, so a press and release within one frame are not lost
+    if (data->fwdr.button_set == 0 && data->fwdr.button_clear == 0) {
+        data->frame_pending = true;
+        if (!k_work_delayable_is_pending(&data->frame_work)) {
+            k_work_schedule(&data->frame_work, zmk_endpoints_frame_period_alt());
+        }
+        return;
+    }
+#endif
+    zip_send_frame(config, data);
+}
+
 static int zip_handle_event(const struct device *dev, struct input_event *event, uint32_t param1,
                             uint32_t param2, struct zmk_input_processor_state *state) {
 
     struct zip_fwd_to_hid_io_data *data = (struct zip_fwd_to_hid_io_data *)dev->data;
     const struct zip_fwd_to_hid_io_config *config = dev->config;
-    
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    k_mutex_lock(&data->lock, K_FOREVER);
+#endif
+
     switch (event->type) {
     case INPUT_EV_REL:
         handle_rel_code(config, data, event);
@@ -148,78 +235,13 @@ static int zip_handle_event(const struct device *dev, struct input_event *event,
     }
 
     if (event->sync) {
+        zip_sync(config, data);
+    }
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO)
-
-    #if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-        if (config->usage == ZIP_HID_IO_USAGE_FWD_TO_JOYSTICK) {
-            if (data->fwdr.data.mode == HID_IO_XY_DATA_MODE_REL) {
-                zmk_hid_joy2_movement_set(data->fwdr.data.x, data->fwdr.data.y);
-            }
-            if (data->fwdr.button_set != 0) {
-                for (int i = 0; i < ZMK_HID_JOYSTICK_NUM_BUTTONS; i++) {
-                    if ((data->fwdr.button_set & BIT(i)) != 0) {
-                        zmk_hid_joy2_button_press(i);
-                    }
-                }
-            }
-            if (data->fwdr.button_clear != 0) {
-                for (int i = 0; i < ZMK_HID_JOYSTICK_NUM_BUTTONS; i++) {
-                    if ((data->fwdr.button_clear & BIT(i)) != 0) {
-                        zmk_hid_joy2_button_release(i);
-                    }
-                }
-            }
-            zmk_endpoints_send_joystick_report_alt();
-            zmk_hid_joy2_movement_set(0, 0);
-        }
-    #endif
-
-    #if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-        if (config->usage == ZIP_HID_IO_USAGE_FWD_TO_MOUSE) {
-            if (data->fwdr.wheel_data.mode == HID_IO_XY_DATA_MODE_REL) {
-                zmk_hid_mou2_scroll_set(data->fwdr.wheel_data.x, data->fwdr.wheel_data.y);
-            }
-            if (data->fwdr.data.mode == HID_IO_XY_DATA_MODE_REL) {
-                zmk_hid_mou2_movement_set(data->fwdr.data.x, data->fwdr.data.y);
-            }
-            if (data->fwdr.button_set != 0) {
-                for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                    if ((data->fwdr.button_set & BIT(i)) != 0) {
-                        zmk_hid_mou2_button_press(i);
-                    }
-                }
-            }
-            if (data->fwdr.button_clear != 0) {
-                for (int i = 0; i < ZMK_HID_MOUSE_NUM_BUTTONS; i++) {
-                    if ((data->fwdr.button_clear & BIT(i)) != 0) {
-                        zmk_hid_mou2_button_release(i);
-                    }
-                }
-            }
-            zmk_endpoints_send_mouse_report_alt();
-            zmk_hid_mou2_scroll_set(0, 0);
-            zmk_hid_mou2_movement_set(0, 0);
-        }
-    #endif
-
-    #if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-        if (config->usage == ZIP_HID_IO_USAGE_FWD_TO_VOLUME_KNOB) {
-            if (data->fwdr.data.mode == HID_IO_XY_DATA_MODE_ABS) {
-                zmk_hid_volume_knob_vol_set(data->fwdr.data.y);
-            }
-            zmk_endpoints_send_volume_knob_report_alt();
-        }
-    #endif
-
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    k_mutex_unlock(&data->lock);
 #endif
 
-        clear_xy_data(&data->fwdr.data);
-        clear_xy_data(&data->fwdr.wheel_data);
-
-        data->fwdr.button_set = data->fwdr.button_clear = 0;
-    }
-
     event->value = 0;
     event->sync = false;
 
@@ -233,6 +255,14 @@ static struct zmk_input_processor_driver_api zip_driver_api = {
 static int zip_init(const struct device *dev) {
     struct zip_fwd_to_hid_io_data *data = dev->data;
     data->dev = dev;
+#if IS_ENABLED(CONFIG_ZMK_HID_IO)
+    const struct zip_fwd_to_hid_io_config *config = dev->config;
+    zmk_hid_io_source_init(&data->source, zip_usage_report_id(config->usage));
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    k_mutex_init(&data->lock);
+    k_work_init_delayable(&data->frame_work, zip_frame_work_cb);
+#endif
     return 0;
 };
 
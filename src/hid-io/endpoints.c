@@ -9,130 +9,182 @@
 #include <zmk/usb_hid.h>
 #include <zmk/hog.h>
 
+#include <zmk/event_manager.h>
+#include <zmk/events/endpoint_changed.h>
+
 #include <zephyr/logging/log.h>
 LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
 
 #include <zmk/hid-io/endpoints.h>
 #include <zmk/hid-io/hid.h>
+#include <zmk/hid-io/report.h>
 #include <zmk/hid-io/usb_hid.h>
 #include <zmk/hid-io/hog.h>
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-int zmk_endpoints_send_joystick_report_alt() {
-    struct zmk_endpoint_instance current_instance = zmk_endpoint_get_selected();
+// Operations of one transport; `send` marks the report sent once the transport took it.
+struct endpoint_transport_alt {
+    int (*send)(const struct zmk_hid_io_report_def *def);
+    // drop the reports queued for this transport and not sent yet
+    void (*discard)(void);
+};
+
+static int send_none_alt(const struct zmk_hid_io_report_def *def) { return 0; }
+
+static const struct endpoint_transport_alt transport_none_alt = {
+    .send = send_none_alt,
+};
 
-    switch (current_instance.transport) {
 #if IS_ENABLED(CONFIG_ZMK_USB)
-    case ZMK_TRANSPORT_USB: {
-        int err = zmk_usb_hid_send_joystick_report_alt();
-        if (err) {
-            LOG_ERR("FAILED TO SEND OVER USB: %d", err);
-        }
+static int send_usb_alt(const struct zmk_hid_io_report_def *def) {
+    int err = zmk_usb_hid_send_report_alt(def);
+    if (err == -EAGAIN) {
+        // host suspended, woken up without taking the report
+        return err;
+    }
+    if (err) {
+        LOG_ERR("FAILED TO SEND OVER USB: %d", err);
         return err;
     }
-#else
-    case ZMK_TRANSPORT_USB: break;
+    zmk_hid_io_report_mark_sent(def);
+    return 0;
+}
+
+static const struct endpoint_transport_alt transport_usb_alt = {
+    .send = send_usb_alt,
+    .discard = zmk_usb_hid_discard_reports_alt,
+};
 #endif /* IS_ENABLED(CONFIG_ZMK_USB) */
 
 #if IS_ENABLED(CONFIG_ZMK_BLE)
-    case ZMK_TRANSPORT_BLE: {
-        struct zmk_hid_joystick_report_alt *joystick_report = zmk_hid_get_joystick_report_alt();
-        int err = zmk_hog_send_joystick_report_alt(&joystick_report->body);
-        if (err) {
-            LOG_ERR("FAILED TO SEND OVER HOG: %d", err);
-        }
+static int send_ble_alt(const struct zmk_hid_io_report_def *def) {
+    if (!zmk_hog_report_subscribed_alt(def)) {
+        return 0;
+    }
+    int err = zmk_hog_send_report_alt(def);
+    if (err) {
+        LOG_ERR("FAILED TO SEND OVER HOG: %d", err);
         return err;
     }
-#else
-    case ZMK_TRANSPORT_BLE: break;
-#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
+    zmk_hid_io_report_mark_sent(def);
+    return 0;
+}
 
-    case ZMK_TRANSPORT_NONE:  {
-        LOG_ERR("Current endpoint transport: NONE");
-        return 0;
-    }
+static const struct endpoint_transport_alt transport_ble_alt = {
+    .send = send_ble_alt,
+    .discard = zmk_hog_discard_reports_alt,
+};
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
 
+static const struct endpoint_transport_alt *endpoint_transport_for(enum zmk_transport transport) {
+    switch (transport) {
+#if IS_ENABLED(CONFIG_ZMK_USB)
+    case ZMK_TRANSPORT_USB:
+        return &transport_usb_alt;
+#endif /* IS_ENABLED(CONFIG_ZMK_USB) */
+#if IS_ENABLED(CONFIG_ZMK_BLE)
+    case ZMK_TRANSPORT_BLE:
+        return &transport_ble_alt;
+#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
+    default:
+        return &transport_none_alt;
     }
-
-    LOG_ERR("Unsupported endpoint transport %d", current_instance.transport);
-    return -ENOTSUP;
 }
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
 
+/*
+ * Selected endpoint and its transport, kept current by the endpoint changed event so the
+ * send path is a single indirect call. Guarded by the report lock; resolved on first use.
+ */
+static struct zmk_endpoint_instance current_endpoint_alt;
+static const struct endpoint_transport_alt *current_transport_alt;
+
+int zmk_endpoints_send_report_alt(uint8_t report_id) {
+    const struct zmk_hid_io_report_def *def = zmk_hid_io_report_get(report_id);
+    if (def == NULL) {
+        LOG_ERR("Unknown HID-IO report ID %d", report_id);
+        return -EINVAL;
+    }
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-int zmk_endpoints_send_mouse_report_alt() {
-    struct zmk_endpoint_instance current_instance = zmk_endpoint_get_selected();
+    // recursive, and already held by the source send cycle
+    zmk_hid_io_report_lock();
 
-    switch (current_instance.transport) {
-#if IS_ENABLED(CONFIG_ZMK_USB)
-    case ZMK_TRANSPORT_USB: {
-        int err = zmk_usb_hid_send_mouse_report_alt();
-        if (err) {
-            LOG_ERR("FAILED TO SEND OVER USB: %d", err);
+    int err = 0;
+    if (zmk_hid_io_report_changed(def)) {
+        if (current_transport_alt == NULL) {
+            current_endpoint_alt = zmk_endpoint_get_selected();
+            current_transport_alt = endpoint_transport_for(current_endpoint_alt.transport);
         }
-        return err;
+        err = current_transport_alt->send(def);
     }
-#else
-    case ZMK_TRANSPORT_USB: break;
-#endif /* IS_ENABLED(CONFIG_ZMK_USB) */
 
-#if IS_ENABLED(CONFIG_ZMK_BLE)
-    case ZMK_TRANSPORT_BLE: {
-        struct zmk_hid_mouse_report_alt *mouse_report = zmk_hid_get_mouse_report_alt();
-        int err = zmk_hog_send_mouse_report_alt(&mouse_report->body);
-        if (err) {
-            LOG_ERR("FAILED TO SEND OVER HOG: %d", err);
-        }
-        return err;
-    }
-#else
-    case ZMK_TRANSPORT_BLE: break;
-#endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
+    zmk_hid_io_report_unlock();
+
+    return err;
+}
 
-    case ZMK_TRANSPORT_NONE: return 0;
+/*
+ * On an endpoint switch, reports still queued for the old endpoint are stale: drop them,
+ * and send the current state of every report on the new one, which has not seen it.
+ */
+static int endpoints_alt_listener(const zmk_event_t *eh) {
+    const struct zmk_endpoint_changed *ev = as_zmk_endpoint_changed(eh);
+    if (ev == NULL) {
+        return ZMK_EV_EVENT_BUBBLE;
     }
 
-    LOG_ERR("Unsupported endpoint transport %d", current_instance.transport);
-    return -ENOTSUP;
-}
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    zmk_hid_io_report_lock();
 
+    if (current_transport_alt == NULL ||
+        !zmk_endpoint_instance_eq(current_endpoint_alt, ev->endpoint)) {
+        if (current_transport_alt != NULL && current_transport_alt->discard != NULL) {
+            current_transport_alt->discard();
+        }
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-int zmk_endpoints_send_volume_knob_report_alt() {
-    struct zmk_endpoint_instance current_instance = zmk_endpoint_get_selected();
+        current_endpoint_alt = ev->endpoint;
+        current_transport_alt = endpoint_transport_for(ev->endpoint.transport);
 
-    switch (current_instance.transport) {
-#if IS_ENABLED(CONFIG_ZMK_USB)
-    case ZMK_TRANSPORT_USB: {
-        int err = zmk_usb_hid_send_volume_knob_report_alt();
-        if (err) {
-            LOG_ERR("FAILED TO SEND OVER USB: %d", err);
+        for (size_t i = 0; i < ZMK_HID_IO_REPORT_COUNT; i++) {
+            current_transport_alt->send(zmk_hid_io_reports[i]);
         }
-        return err;
     }
-#else
-    case ZMK_TRANSPORT_USB: break;
-#endif /* IS_ENABLED(CONFIG_ZMK_USB) */
 
+    zmk_hid_io_report_unlock();
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(endpoints_alt, endpoints_alt_listener);
+ZMK_SUBSCRIPTION(endpoints_alt, zmk_endpoint_changed);
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+k_timeout_t zmk_endpoints_frame_period_alt(void) {
+    switch (zmk_endpoint_get_selected().transport) {
 #if IS_ENABLED(CONFIG_ZMK_BLE)
     case ZMK_TRANSPORT_BLE: {
-        struct zmk_hid_volume_knob_report_alt *volume_knob_report = zmk_hid_get_volume_knob_report_alt();
-        int err = zmk_hog_send_volume_knob_report_alt(&volume_knob_report->body);
-        if (err) {
-            LOG_ERR("FAILED TO SEND OVER HOG: %d", err);
-        }
-        return err;
+        uint32_t interval_us = zmk_hog_conn_interval_us_alt();
+        return K_USEC(interval_us > 0 ? interval_us
+                                      : CONFIG_ZMK_HID_IO_FRAME_BLE_DEFAULT_PERIOD_US);
     }
-#else
-    case ZMK_TRANSPORT_BLE: break;
 #endif /* IS_ENABLED(CONFIG_ZMK_BLE) */
-
-    case ZMK_TRANSPORT_NONE: return 0;
+    default:
+        return K_USEC(CONFIG_ZMK_HID_IO_FRAME_USB_PERIOD_US);
     }
+}
+#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
 
-    LOG_ERR("Unsupported endpoint transport %d", current_instance.transport);
-    return -ENOTSUP;
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+int zmk_endpoints_send_joystick_report_alt() {
+    return zmk_endpoints_send_report_alt(ZMK_HID_REPORT_ID__IO_JOYSTICK);
+}
+#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+int zmk_endpoints_send_mouse_report_alt() {
+    return zmk_endpoints_send_report_alt(ZMK_HID_REPORT_ID__IO_MOUSE);
+}
+#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+int zmk_endpoints_send_volume_knob_report_alt() {
+    return zmk_endpoints_send_report_alt(ZMK_HID_REPORT_ID__IO_VOLUME_KNOB);
 }
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
@@ -15,17 +15,20 @@ LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
 
 #include <zmk/hid-io/hid.h>
 #include <zmk/hid-io/hid_joystick.h>
+#include <zmk/hid-io/report.h>
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
 
 static struct zmk_hid_joystick_report_alt joystick_report_alt = {
     .report_id = ZMK_HID_REPORT_ID__IO_JOYSTICK,
-    .body = { .d_x = 0, .d_y = 0, .d_z = 0,  .d_rx = 0, .d_ry = 0, .d_rz = 0,
-              .buttons = 0 }};
+    .body = {0}};
+
+BUILD_ASSERT(sizeof(joystick_report_alt.body) * 8 == ZMK_HID_IO_JOYSTICK_BODY_BITS,
+             "Joystick report body out of sync with the report descriptor");
 
 // Keep track of how often a button was pressed.
 // Only release the button if the count is 0.
-static int explicit_joy2_btn_counts[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+static int explicit_joy2_btn_counts[ZMK_HID_JOYSTICK_NUM_BUTTONS];
 static zmk_mod_flags_t explicit_joy2_btns = 0;
 
 #define SET_JOYSTICK_BUTTONS(btns)                                                                 \
@@ -114,8 +117,64 @@ void zmk_hid_joy2_clear(void) {
     memset(&joystick_report_alt.body, 0, sizeof(joystick_report_alt.body));
 }
 
+// Two reports may be merged into one while their button state is the same.
+static bool joy2_report_mergeable(const void *body, const void *next) {
+    const struct zmk_hid_joystick_report_body_alt *a = body, *b = next;
+    return a->buttons == b->buttons;
+}
+
+// Axes are declared as symmetric relative values in the report descriptor.
+static zmk_hid_io_joystick_axis_t joy2_axis_add_sat(int32_t a, int32_t b) {
+    return (zmk_hid_io_joystick_axis_t)CLAMP(a + b, -ZMK_HID_IO_JOYSTICK_AXIS_MAX,
+                                             ZMK_HID_IO_JOYSTICK_AXIS_MAX);
+}
+
+// Add the relative motion of src into dst, saturating each axis. Buttons are untouched.
+static void joy2_report_merge(void *body, const void *next) {
+    struct zmk_hid_joystick_report_body_alt *dst = body;
+    const struct zmk_hid_joystick_report_body_alt *src = next;
+    dst->d_x = joy2_axis_add_sat(dst->d_x, src->d_x);
+    dst->d_y = joy2_axis_add_sat(dst->d_y, src->d_y);
+#if ZMK_HID_IO_JOYSTICK_AXES > 2
+    dst->d_z = joy2_axis_add_sat(dst->d_z, src->d_z);
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 3
+    dst->d_rx = joy2_axis_add_sat(dst->d_rx, src->d_rx);
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 4
+    dst->d_ry = joy2_axis_add_sat(dst->d_ry, src->d_ry);
+#endif
+#if ZMK_HID_IO_JOYSTICK_AXES > 5
+    dst->d_rz = joy2_axis_add_sat(dst->d_rz, src->d_rz);
+#endif
+}
+
 struct zmk_hid_joystick_report_alt *zmk_hid_get_joystick_report_alt(void) {
     return &joystick_report_alt;
 }
 
+static bool joy2_report_idle(const void *body) {
+    const struct zmk_hid_joystick_report_body_alt *b = body;
+    // every field but the trailing button byte is an axis
+    const struct zmk_hid_joystick_report_body_alt idle = {.buttons = b->buttons};
+    return memcmp(b, &idle, sizeof(idle)) == 0;
+}
+
+static struct zmk_hid_joystick_report_body_alt joystick_last_sent_alt;
+static struct zmk_hid_io_report_snapshot joystick_snapshot_alt =
+    ZMK_HID_IO_REPORT_SNAPSHOT_INIT(ZMK_HID_REPORT_ID__IO_JOYSTICK);
+
+const struct zmk_hid_io_report_def zmk_hid_io_report_def_joystick = {
+    .id = ZMK_HID_REPORT_ID__IO_JOYSTICK,
+    .index = ZMK_HID_IO_REPORT_JOYSTICK,
+    .policy = ZMK_HID_IO_REPORT_POLICY_RELATIVE,
+    .report = (uint8_t *)&joystick_report_alt,
+    .body_size = sizeof(joystick_report_alt.body),
+    .mergeable = joy2_report_mergeable,
+    .merge = joy2_report_merge,
+    .idle = joy2_report_idle,
+    .last_sent = (uint8_t *)&joystick_last_sent_alt,
+    .snapshot = &joystick_snapshot_alt,
+};
+
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
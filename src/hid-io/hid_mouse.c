@@ -15,6 +15,7 @@ LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
 
 #include <zmk/hid-io/hid.h>
 #include <zmk/hid-io/hid_mouse.h>
+#include <zmk/hid-io/report.h>
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
 
@@ -22,9 +23,12 @@ static struct zmk_hid_mouse_report_alt mouse_report_alt = {
     .report_id = ZMK_HID_REPORT_ID__IO_MOUSE,
     .body = { .buttons = 0, .d_x = 0, .d_y = 0, .d_scroll_y = 0, .d_scroll_x = 0 }};
 
+BUILD_ASSERT(sizeof(mouse_report_alt.body) * 8 == ZMK_HID_IO_MOUSE_BODY_BITS,
+             "Mouse report body out of sync with the report descriptor");
+
 // Keep track of how often a button was pressed.
 // Only release the button if the count is 0.
-static int explicit_mou2_btn_counts[5] = {0, 0, 0, 0, 0};
+static int explicit_mou2_btn_counts[ZMK_HID_MOUSE_NUM_BUTTONS];
 static zmk_mod_flags_t explicit_mou2_btns = 0;
 
 #define SET_MOUSE_BUTTONS(btns)                                                                    \
@@ -113,8 +117,51 @@ void zmk_hid_mou2_clear(void) {
     memset(&mouse_report_alt.body, 0, sizeof(mouse_report_alt.body));
 }
 
+// Two reports may be merged into one while their button state is the same.
+static bool mou2_report_mergeable(const void *body, const void *next) {
+    const struct zmk_hid_mouse_report_body_alt *a = body, *b = next;
+    return a->buttons == b->buttons;
+}
+
+// Fields are declared as symmetric relative values in the report descriptor.
+static int32_t mou2_add_sat(int32_t a, int32_t b, int32_t limit) {
+    return CLAMP(a + b, -limit, limit);
+}
+
+// Add the relative motion of src into dst, saturating each axis. Buttons are untouched.
+static void mou2_report_merge(void *body, const void *next) {
+    struct zmk_hid_mouse_report_body_alt *dst = body;
+    const struct zmk_hid_mouse_report_body_alt *src = next;
+    dst->d_x = mou2_add_sat(dst->d_x, src->d_x, ZMK_HID_IO_MOUSE_AXIS_MAX);
+    dst->d_y = mou2_add_sat(dst->d_y, src->d_y, ZMK_HID_IO_MOUSE_AXIS_MAX);
+    dst->d_scroll_y = mou2_add_sat(dst->d_scroll_y, src->d_scroll_y, ZMK_HID_IO_MOUSE_WHEEL_MAX);
+    dst->d_scroll_x = mou2_add_sat(dst->d_scroll_x, src->d_scroll_x, ZMK_HID_IO_MOUSE_WHEEL_MAX);
+}
+
 struct zmk_hid_mouse_report_alt *zmk_hid_get_mouse_report_alt(void) {
     return &mouse_report_alt;
 }
 
+static bool mou2_report_idle(const void *body) {
+    const struct zmk_hid_mouse_report_body_alt *b = body;
+    return b->d_x == 0 && b->d_y == 0 && b->d_scroll_x == 0 && b->d_scroll_y == 0;
+}
+
+static struct zmk_hid_mouse_report_body_alt mouse_last_sent_alt;
+static struct zmk_hid_io_report_snapshot mouse_snapshot_alt =
+    ZMK_HID_IO_REPORT_SNAPSHOT_INIT(ZMK_HID_REPORT_ID__IO_MOUSE);
+
+const struct zmk_hid_io_report_def zmk_hid_io_report_def_mouse = {
+    .id = ZMK_HID_REPORT_ID__IO_MOUSE,
+    .index = ZMK_HID_IO_REPORT_MOUSE,
+    .policy = ZMK_HID_IO_REPORT_POLICY_RELATIVE,
+    .report = (uint8_t *)&mouse_report_alt,
+    .body_size = sizeof(mouse_report_alt.body),
+    .mergeable = mou2_report_mergeable,
+    .merge = mou2_report_merge,
+    .idle = mou2_report_idle,
+    .last_sent = (uint8_t *)&mouse_last_sent_alt,
+    .snapshot = &mouse_snapshot_alt,
+};
+
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
@@ -15,6 +15,7 @@ LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
 
 #include <zmk/hid-io/hid.h>
 #include <zmk/hid-io/hid_volume_knob.h>
+#include <zmk/hid-io/report.h>
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
 
@@ -22,6 +23,9 @@ static struct zmk_hid_volume_knob_report_alt volume_knob_report_alt = {
     .report_id = ZMK_HID_REPORT_ID__IO_VOLUME_KNOB,
     .body = { .d_vol = 0 }};
 
+BUILD_ASSERT(sizeof(volume_knob_report_alt.body) * 8 == ZMK_HID_IO_VOLUME_KNOB_BODY_BITS,
+             "Volume knob report body out of sync with the report descriptor");
+
 void zmk_hid_volume_knob_vol_set(uint8_t vol) {
     volume_knob_report_alt.body.d_vol = vol;
     LOG_DBG("vol knob vol set to %d", volume_knob_report_alt.body.d_vol);
@@ -41,4 +45,18 @@ struct zmk_hid_volume_knob_report_alt *zmk_hid_get_volume_knob_report_alt(void)
     return &volume_knob_report_alt;
 }
 
+static struct zmk_hid_volume_knob_report_body_alt volume_knob_last_sent_alt;
+static struct zmk_hid_io_report_snapshot volume_knob_snapshot_alt =
+    ZMK_HID_IO_REPORT_SNAPSHOT_INIT(ZMK_HID_REPORT_ID__IO_VOLUME_KNOB);
+
+const struct zmk_hid_io_report_def zmk_hid_io_report_def_volume_knob = {
+    .id = ZMK_HID_REPORT_ID__IO_VOLUME_KNOB,
+    .index = ZMK_HID_IO_REPORT_VOLUME_KNOB,
+    .policy = ZMK_HID_IO_REPORT_POLICY_LATEST,
+    .report = (uint8_t *)&volume_knob_report_alt,
+    .body_size = sizeof(volume_knob_report_alt.body),
+    .last_sent = (uint8_t *)&volume_knob_last_sent_alt,
+    .snapshot = &volume_knob_snapshot_alt,
+};
+
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
@@ -15,10 +15,15 @@ LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
 
 #include <zmk/ble.h>
 #include <zmk/endpoints_types.h>
+#include <zmk/event_manager.h>
+#include <zmk/events/ble_active_profile_changed.h>
 #include <zmk/hog.h>
 #include <zmk/hid.h>
 
 #include <zmk/hid-io/hid.h>
+#include <zmk/hid-io/hog.h>
+#include <zmk/hid-io/link.h>
+#include <zmk/hid-io/report.h>
 
 enum {
     HIDS_REMOTE_WAKE = BIT(0),
@@ -84,7 +89,14 @@ static struct hids_report volume_knob_input = {
 
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
 
-static bool host_requests_notification = false;
+/*
+ * Bit per input report index, set while the connection of the active profile has
+ * notifications enabled on that report. The aggregated CCC value is not used, it covers
+ * every bonded peer.
+ */
+static atomic_t subscribed_reports = ATOMIC_INIT(0);
+
+BUILD_ASSERT(ZMK_HID_IO_REPORT_COUNT <= ATOMIC_BITS, "subscribed_reports holds one bit per report");
 static uint8_t ctrl_point;
 // static uint8_t proto_mode;
 
@@ -135,38 +147,34 @@ static ssize_t write_hids_output_report(struct bt_conn *conn, const struct bt_ga
 
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_OUTPUT)
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-size_t bt_gatt_char_offset_joystick = 0;
-static ssize_t read_hids_joystick_input_report(struct bt_conn *conn, const struct bt_gatt_attr *attr,
-                                            void *buf, uint16_t len, uint16_t offset) {
-    struct zmk_hid_joystick_report_body_alt *report_body = &zmk_hid_get_joystick_report_alt()->body;
-    return bt_gatt_attr_read(conn, attr, buf, len, offset, report_body,
-                             sizeof(struct zmk_hid_joystick_report_body_alt));
-}
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+// Value attribute of an input report characteristic; user_data is its report definition.
+static ssize_t read_hids_input_report(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                                      void *buf, uint16_t len, uint16_t offset) {
+    const struct zmk_hid_io_report_def *def = attr->user_data;
+    union zmk_hid_io_report_any report;
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-size_t bt_gatt_char_offset_mouse = 0;
-static ssize_t read_hids_mouse_input_report(struct bt_conn *conn, const struct bt_gatt_attr *attr,
-                                            void *buf, uint16_t len, uint16_t offset) {
-    struct zmk_hid_mouse_report_body_alt *report_body = &zmk_hid_get_mouse_report_alt()->body;
-    return bt_gatt_attr_read(conn, attr, buf, len, offset, report_body,
-                             sizeof(struct zmk_hid_mouse_report_body_alt));
+    zmk_hid_io_report_read(def, &report);
+    return bt_gatt_attr_read(conn, attr, buf, len, offset, (uint8_t *)&report + 1,
+                             def->body_size);
 }
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-size_t bt_gatt_char_offset_volume_knob = 0;
-static ssize_t read_hids_volume_knob_input_report(struct bt_conn *conn, const struct bt_gatt_attr *attr,
-                                                  void *buf, uint16_t len, uint16_t offset) {
-    struct zmk_hid_volume_knob_report_body_alt *report_body = &zmk_hid_get_volume_knob_report_alt()->body;
-    return bt_gatt_attr_read(conn, attr, buf, len, offset, report_body,
-                             sizeof(struct zmk_hid_volume_knob_report_body_alt));
+static bool hog_alt_is_active_conn(const struct bt_conn *conn);
+
+// Called for the CCC write of every peer, before the aggregated value is updated.
+static ssize_t input_ccc_write(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+                               uint16_t value) {
+    // the CCC descriptor directly follows the value attribute of its characteristic
+    const struct zmk_hid_io_report_def *def = (attr - 1)->user_data;
+    bool subscribed = (value & BT_GATT_CCC_NOTIFY) != 0;
+    if (hog_alt_is_active_conn(conn)) {
+        atomic_set_bit_to(&subscribed_reports, def->index, subscribed);
+    }
+    LOG_DBG("Report %d notifications %s", def->id, subscribed ? "enabled" : "disabled");
+    return sizeof(value);
 }
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
 
-static void input_ccc_changed(const struct bt_gatt_attr *attr, uint16_t value) {
-    host_requests_notification = (value == BT_GATT_CCC_NOTIFY) ? 1 : 0;
+bool zmk_hog_report_subscribed_alt(const struct zmk_hid_io_report_def *def) {
+    return atomic_test_bit(&subscribed_reports, def->index);
 }
 
 static ssize_t write_ctrl_point(struct bt_conn *conn, const struct bt_gatt_attr *attr,
@@ -182,6 +190,56 @@ static ssize_t write_ctrl_point(struct bt_conn *conn, const struct bt_gatt_attr
     return len;
 }
 
+/*
+ * Attribute indices of hog_svc_alt, in declaration order. BT_GATT_CHARACTERISTIC() emits a
+ * declaration and a value attribute, BT_GATT_CCC() and BT_GATT_DESCRIPTOR() one each. Keep
+ * in sync with the service definition below, the build asserts check the total.
+ */
+enum {
+    HOG_ATTR_SERVICE,
+    HOG_ATTR_INFO_CHRC,
+    HOG_ATTR_INFO_VALUE,
+    HOG_ATTR_REPORT_MAP_CHRC,
+    HOG_ATTR_REPORT_MAP_VALUE,
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    HOG_ATTR_JOYSTICK_CHRC,
+    HOG_ATTR_JOYSTICK_VALUE,
+    HOG_ATTR_JOYSTICK_CCC,
+    HOG_ATTR_JOYSTICK_REF,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    HOG_ATTR_MOUSE_CHRC,
+    HOG_ATTR_MOUSE_VALUE,
+    HOG_ATTR_MOUSE_CCC,
+    HOG_ATTR_MOUSE_REF,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_OUTPUT)
+    HOG_ATTR_OUTPUT_CHRC,
+    HOG_ATTR_OUTPUT_VALUE,
+    HOG_ATTR_OUTPUT_REF,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+    HOG_ATTR_VOLUME_KNOB_CHRC,
+    HOG_ATTR_VOLUME_KNOB_VALUE,
+    HOG_ATTR_VOLUME_KNOB_CCC,
+    HOG_ATTR_VOLUME_KNOB_REF,
+#endif
+    HOG_ATTR_CTRL_POINT_CHRC,
+    HOG_ATTR_CTRL_POINT_VALUE,
+    HOG_ATTR_COUNT,
+};
+
+// Characteristic, CCC and report reference of one input report.
+#define HOG_INPUT_REPORT_ATTRS(_def, _ref)                                                         \
+    BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,           \
+                           BT_GATT_PERM_READ_ENCRYPT, read_hids_input_report, NULL,                \
+                           (void *)&(_def)),                                                       \
+        BT_GATT_CCC_MANAGED(                                                                       \
+            ((struct _bt_gatt_ccc[]){BT_GATT_CCC_INITIALIZER(NULL, input_ccc_write, NULL)}),       \
+            BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),                               \
+        BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ_ENCRYPT,                     \
+                           read_hids_report_ref, NULL, &(_ref))
+
 /* HID Service Declaration */
 BT_GATT_SERVICE_DEFINE(
     hog_svc_alt, BT_GATT_PRIMARY_SERVICE(BT_UUID_HIDS),
@@ -191,19 +249,11 @@ BT_GATT_SERVICE_DEFINE(
                            read_hids_report_map, NULL, NULL),
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-    BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
-                           BT_GATT_PERM_READ_ENCRYPT, read_hids_joystick_input_report, NULL, NULL),
-    BT_GATT_CCC(input_ccc_changed, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
-    BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ_ENCRYPT, read_hids_report_ref,
-                       NULL, &joystick_input),
+    HOG_INPUT_REPORT_ATTRS(zmk_hid_io_report_def_joystick, joystick_input),
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-    BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
-                           BT_GATT_PERM_READ_ENCRYPT, read_hids_mouse_input_report, NULL, NULL),
-    BT_GATT_CCC(input_ccc_changed, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
-    BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ_ENCRYPT, read_hids_report_ref,
-                       NULL, &mouse_input),
+    HOG_INPUT_REPORT_ATTRS(zmk_hid_io_report_def_mouse, mouse_input),
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_OUTPUT)
@@ -216,226 +266,896 @@ BT_GATT_SERVICE_DEFINE(
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_OUTPUT)
 
 #if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-    BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY,
-                           BT_GATT_PERM_READ_ENCRYPT, read_hids_volume_knob_input_report, NULL, NULL),
-    BT_GATT_CCC(input_ccc_changed, BT_GATT_PERM_READ_ENCRYPT | BT_GATT_PERM_WRITE_ENCRYPT),
-    BT_GATT_DESCRIPTOR(BT_UUID_HIDS_REPORT_REF, BT_GATT_PERM_READ_ENCRYPT, read_hids_report_ref,
-                       NULL, &volume_knob_input),
+    HOG_INPUT_REPORT_ATTRS(zmk_hid_io_report_def_volume_knob, volume_knob_input),
 #endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
 
     BT_GATT_CHARACTERISTIC(BT_UUID_HIDS_CTRL_POINT, BT_GATT_CHRC_WRITE_WITHOUT_RESP,
                            BT_GATT_PERM_WRITE, NULL, write_ctrl_point, &ctrl_point));
 
-struct bt_conn *destination_connection_alt(void) {
-    struct bt_conn *conn;
+BUILD_ASSERT(ARRAY_SIZE(attr_hog_svc_alt) == HOG_ATTR_COUNT,
+             "HOG attribute indices out of sync with hog_svc_alt");
+
+static void hog_alt_resume_send(void);
+static void hog_alt_notify_link_lost(void);
+static void hog_alt_refresh_subscriptions(struct bt_conn *conn);
+
+/*
+ * Set while a security elevation requested after a -EPERM notify is outstanding. Queued
+ * reports are held (and keep coalescing) until security_changed, then flushed at once.
+ */
+static atomic_t hog_alt_security_pending = ATOMIC_INIT(0);
+
+/*
+ * The connection of the active profile, kept current by the connection callbacks and the
+ * active profile changed event so the send path does not look it up for every report.
+ * The cache holds its own reference.
+ */
+static struct bt_conn *active_conn_alt;
+static struct k_spinlock active_conn_alt_lock;
+
+static void update_active_connection_alt(struct bt_conn *disconnecting) {
+    struct bt_conn *conn = NULL;
     bt_addr_le_t *addr = zmk_ble_active_profile_addr();
-    // LOG_DBG("Address pointer %p", addr);
-    if (!bt_addr_le_cmp(addr, BT_ADDR_LE_ANY)) {
-        LOG_WRN("Not sending, no active address for current profile");
-        return NULL;
-    } else if ((conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, addr)) == NULL) {
-        LOG_WRN("Not sending, not connected to active profile");
-        return NULL;
+
+    if (bt_addr_le_cmp(addr, BT_ADDR_LE_ANY)) {
+        conn = bt_conn_lookup_addr_le(BT_ID_DEFAULT, addr);
+        if (conn != NULL && conn == disconnecting) {
+            bt_conn_unref(conn);
+            conn = NULL;
+        }
+    }
+
+    // CCCs of a bonded peer are restored on encryption, so this also runs on security_changed
+    hog_alt_refresh_subscriptions(conn);
+
+    k_spinlock_key_t key = k_spin_lock(&active_conn_alt_lock);
+    struct bt_conn *old = active_conn_alt;
+    active_conn_alt = conn;
+    k_spin_unlock(&active_conn_alt_lock, key);
+
+    if (old != NULL) {
+        bt_conn_unref(old);
+    }
+
+    // reports queued while the active profile had no connection go out now
+    if (conn != NULL && conn != old) {
+        hog_alt_resume_send();
+    }
+}
+
+static void hog_alt_connected(struct bt_conn *conn, uint8_t err) {
+    if (err) {
+        return;
+    }
+    update_active_connection_alt(NULL);
+}
+
+static void hog_alt_disconnected(struct bt_conn *conn, uint8_t reason) {
+    update_active_connection_alt(conn);
+    atomic_clear(&hog_alt_security_pending);
+    hog_alt_notify_link_lost();
+}
+
+static void hog_alt_security_changed(struct bt_conn *conn, bt_security_t level,
+                                     enum bt_security_err err) {
+    update_active_connection_alt(NULL);
+
+    if (atomic_cas(&hog_alt_security_pending, 1, 0)) {
+        if (err) {
+            LOG_WRN("Security elevation failed (%d), held reports will be retried", err);
+        }
+        hog_alt_resume_send();
+    }
+}
+
+BT_CONN_CB_DEFINE(hog_alt_conn_callbacks) = {
+    .connected = hog_alt_connected,
+    .disconnected = hog_alt_disconnected,
+    .security_changed = hog_alt_security_changed,
+};
+
+static int hog_alt_listener(const zmk_event_t *eh) {
+    if (as_zmk_ble_active_profile_changed(eh) != NULL) {
+        update_active_connection_alt(NULL);
+    }
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(hog_alt, hog_alt_listener);
+ZMK_SUBSCRIPTION(hog_alt, zmk_ble_active_profile_changed);
+
+static bool hog_alt_is_active_conn(const struct bt_conn *conn) {
+    k_spinlock_key_t key = k_spin_lock(&active_conn_alt_lock);
+    bool active = conn != NULL && conn == active_conn_alt;
+    k_spin_unlock(&active_conn_alt_lock, key);
+    return active;
+}
+
+// Returns a new reference to the active connection, or NULL. Caller must unref.
+struct bt_conn *destination_connection_alt(void) {
+    struct bt_conn *conn = NULL;
+
+    k_spinlock_key_t key = k_spin_lock(&active_conn_alt_lock);
+    if (active_conn_alt != NULL) {
+        conn = bt_conn_ref(active_conn_alt);
+    }
+    k_spin_unlock(&active_conn_alt_lock, key);
+
+    if (conn == NULL) {
+        LOG_DBG("Not sending, not connected to active profile");
     }
 
     return conn;
 }
 
-K_THREAD_STACK_DEFINE(hog_alt_q_stack, CONFIG_ZMK_BLE_THREAD_STACK_SIZE);
+uint32_t zmk_hog_conn_interval_us_alt(void) {
+    struct bt_conn_info info;
+    uint32_t interval_us = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&active_conn_alt_lock);
+    if (active_conn_alt != NULL && bt_conn_get_info(active_conn_alt, &info) == 0) {
+        // connection interval is in units of 1.25 ms
+        interval_us = info.le.interval * 1250U;
+    }
+    k_spin_unlock(&active_conn_alt_lock, key);
+
+    return interval_us;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_WORK_QUEUE_DEDICATED)
+K_THREAD_STACK_DEFINE(hog_alt_q_stack, CONFIG_ZMK_HID_IO_BLE_WORK_QUEUE_STACK_SIZE);
 
 struct k_work_q hog_alt_work_q;
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+#define HOG_ALT_WORK_Q (&hog_alt_work_q)
+#define HOG_ALT_WORK_Q_NAME "dedicated"
+#define HOG_ALT_WORK_Q_RAM                                                                         \
+    (K_THREAD_STACK_LEN(CONFIG_ZMK_HID_IO_BLE_WORK_QUEUE_STACK_SIZE) + sizeof(struct k_work_q))
+#elif IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_WORK_QUEUE_ZMK_HOG)
+// ZMK's own HOG send queue, see app/src/hog.c
+extern struct k_work_q hog_work_q;
+
+#define HOG_ALT_WORK_Q (&hog_work_q)
+#define HOG_ALT_WORK_Q_NAME "ZMK HOG"
+#define HOG_ALT_WORK_Q_RAM 0
+#else
+#define HOG_ALT_WORK_Q (&k_sys_work_q)
+#define HOG_ALT_WORK_Q_NAME "system"
+#define HOG_ALT_WORK_Q_RAM 0
+#endif
 
-K_MSGQ_DEFINE(zmk_hog_joystick_alt_msgq, sizeof(struct zmk_hid_joystick_report_body_alt),
-              CONFIG_ZMK_HID_IO_BLE_JOYSTICK_REPORT_QUEUE_SIZE, 4);
+// RAM saved against a dedicated queue with a BLE thread sized stack.
+#define HOG_ALT_WORK_Q_RAM_SAVED                                                                   \
+    ((int)(K_THREAD_STACK_LEN(CONFIG_ZMK_BLE_THREAD_STACK_SIZE) + sizeof(struct k_work_q)) -       \
+     (int)HOG_ALT_WORK_Q_RAM)
 
-void send_joystick_report_alt_callback(struct k_work *work) {
-    struct zmk_hid_joystick_report_body_alt report;
-    while (k_msgq_get(&zmk_hog_joystick_alt_msgq, &report, K_NO_WAIT) == 0) {
-        struct bt_conn *conn = destination_connection_alt();
-        if (conn == NULL) {
-            return;
-        }
+/*
+ * Queued reports of all usages share one pool of blocks. Each block carries its own list
+ * node and tag, so a usage queue is an intrusive list of blocks and needs no storage of
+ * its own. Report bodies are copied once from the live report into a block and handed to
+ * bt_gatt_notify_cb() as is. The stack copies the data into its own buffer before it
+ * returns, so the block is released right away: a notification lost with its link never
+ * holds on to a block. The pool size bounds the number of reports queued across all usages.
+ */
+struct hog_report_buf {
+    sys_snode_t node;
+    // k_uptime_get() of the oldest report folded into this block
+    int64_t stamp;
+    // changes the button/state of the report
+    bool transition;
+    uint8_t body[];
+};
+
+K_MEM_SLAB_DEFINE_STATIC(hog_alt_report_slab,
+                         ROUND_UP(sizeof(struct hog_report_buf) + ZMK_HID_IO_REPORT_MAX_SIZE - 1,
+                                  8),
+                         CONFIG_ZMK_HID_IO_BLE_REPORT_POOL_SIZE, 8);
+
+static void hog_alt_report_buf_free(struct hog_report_buf *buf) {
+    k_mem_slab_free(&hog_alt_report_slab, buf);
+}
+
+/*
+ * Credit based flow control: at most CONFIG_ZMK_HID_IO_BLE_NOTIFY_WINDOW notifications are
+ * outstanding in the stack. A credit is returned when a notification completes, which
+ * resumes sending; reports that do not fit stay queued (and keep coalescing) instead of
+ * being thrown at a full controller.
+ */
+static atomic_t hog_alt_notify_credits = ATOMIC_INIT(CONFIG_ZMK_HID_IO_BLE_NOTIFY_WINDOW);
 
-        struct bt_gatt_notify_params notify_params = {
-            .attr = &hog_svc_alt.attrs[ bt_gatt_char_offset_joystick ],
-            .data = &report,
-            .len = sizeof(report),
-        };
-
-        int err = bt_gatt_notify_cb(conn, &notify_params);
-        if (err == -EPERM) {
-            bt_conn_set_security(conn, BT_SECURITY_L2);
-        } else if (err) {
-            LOG_DBG("Error notifying %d", err);
+// Retry delay when the stack is out of buffers but none of our notifications is in flight.
+#define HOG_ALT_NOTIFY_RETRY_MS 5
+
+static bool hog_alt_take_notify_credit(void) {
+    atomic_val_t credits;
+    do {
+        credits = atomic_get(&hog_alt_notify_credits);
+        if (credits <= 0) {
+            return false;
         }
+    } while (!atomic_cas(&hog_alt_notify_credits, credits, credits - 1));
+    return true;
+}
+
+static void hog_alt_give_notify_credit(void) { atomic_inc(&hog_alt_notify_credits); }
+
+/*
+ * The completion callback only runs for notifications that were transmitted; the ones lost
+ * with a link never return their credit. Each notification carries the generation it was
+ * issued in. A disconnect starts a new generation with a full window, and completions of
+ * an earlier one are ignored. The lock keeps a completion from crediting across a reset.
+ */
+static uint32_t hog_alt_notify_gen;
+static struct k_spinlock hog_alt_notify_gen_lock;
+
+static void hog_alt_notify_complete(struct bt_conn *conn, void *user_data) {
+    k_spinlock_key_t key = k_spin_lock(&hog_alt_notify_gen_lock);
+    bool current = (uintptr_t)user_data == hog_alt_notify_gen;
+    if (current) {
+        hog_alt_give_notify_credit();
+    }
+    k_spin_unlock(&hog_alt_notify_gen_lock, key);
 
-        bt_conn_unref(conn);
+    if (current) {
+        hog_alt_resume_send();
     }
+}
+
+static void *hog_alt_notify_gen_get(void) {
+    k_spinlock_key_t key = k_spin_lock(&hog_alt_notify_gen_lock);
+    uintptr_t gen = hog_alt_notify_gen;
+    k_spin_unlock(&hog_alt_notify_gen_lock, key);
+    return (void *)gen;
+}
+
+// Runs on the send work queue, so no send round holds credits meanwhile.
+static void hog_alt_reset_credits(struct k_work *work) {
+    k_spinlock_key_t key = k_spin_lock(&hog_alt_notify_gen_lock);
+    hog_alt_notify_gen++;
+    atomic_set(&hog_alt_notify_credits, CONFIG_ZMK_HID_IO_BLE_NOTIFY_WINDOW);
+    k_spin_unlock(&hog_alt_notify_gen_lock, key);
+
+    hog_alt_resume_send();
+}
+
+static K_WORK_DEFINE(hog_alt_reset_credits_work, hog_alt_reset_credits);
+
+static void hog_alt_retry_send(struct k_work *work) { hog_alt_resume_send(); }
+
+static K_WORK_DELAYABLE_DEFINE(hog_alt_retry_work, hog_alt_retry_send);
+
+struct hog_report_queue {
+    struct k_spinlock lock;
+    // queued blocks, oldest first
+    sys_slist_t list;
+    // max number of blocks this usage may hold out of the shared pool
+    size_t capacity;
+    size_t count;
+    // pure motion older than this is expired at dequeue, 0 = never
+    uint32_t deadline_ms;
+    // newest body queued, to classify the next report once the queue has drained
+    uint8_t last[ZMK_HID_IO_REPORT_MAX_SIZE];
 };
 
-K_WORK_DEFINE(hog_alt_joystick_work, send_joystick_report_alt_callback);
+#define HOG_REPORT_QUEUE_INIT(_capacity, _deadline_ms)                                            \
+    {.capacity = (_capacity), .deadline_ms = (_deadline_ms)}
 
-int zmk_hog_send_joystick_report_alt(struct zmk_hid_joystick_report_body_alt *report) {
-    int err = k_msgq_put(&zmk_hog_joystick_alt_msgq, report, K_MSEC(100));
-    if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("joystick message queue full, popping first message and queueing again");
-            struct zmk_hid_joystick_report_body_alt discarded_report;
-            k_msgq_get(&zmk_hog_joystick_alt_msgq, &discarded_report, K_NO_WAIT);
-            return zmk_hog_send_joystick_report_alt(report);
+// One queue per registered input report, indexed by zmk_hid_io_report_def.index.
+static struct hog_report_queue hog_report_queues[ZMK_HID_IO_REPORT_COUNT] = {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    [ZMK_HID_IO_REPORT_JOYSTICK] =
+        HOG_REPORT_QUEUE_INIT(CONFIG_ZMK_HID_IO_BLE_JOYSTICK_REPORT_QUEUE_SIZE,
+                              CONFIG_ZMK_HID_IO_BLE_JOYSTICK_REPORT_DEADLINE_MS),
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    [ZMK_HID_IO_REPORT_MOUSE] =
+        HOG_REPORT_QUEUE_INIT(CONFIG_ZMK_HID_IO_BLE_MOUSE_REPORT_QUEUE_SIZE,
+                              CONFIG_ZMK_HID_IO_BLE_MOUSE_REPORT_DEADLINE_MS),
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+    // latest-wins mailbox
+    [ZMK_HID_IO_REPORT_VOLUME_KNOB] = HOG_REPORT_QUEUE_INIT(1, 0),
+#endif
+};
+
+// Characteristic of each input report, notified through its declaration attribute.
+static const struct bt_gatt_attr *const input_report_attrs[ZMK_HID_IO_REPORT_COUNT] = {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    [ZMK_HID_IO_REPORT_JOYSTICK] = &attr_hog_svc_alt[HOG_ATTR_JOYSTICK_CHRC],
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    [ZMK_HID_IO_REPORT_MOUSE] = &attr_hog_svc_alt[HOG_ATTR_MOUSE_CHRC],
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+    [ZMK_HID_IO_REPORT_VOLUME_KNOB] = &attr_hog_svc_alt[HOG_ATTR_VOLUME_KNOB_CHRC],
+#endif
+};
+
+// Read the subscriptions of a connection about to become the active one.
+static void hog_alt_refresh_subscriptions(struct bt_conn *conn) {
+    for (size_t i = 0; i < ZMK_HID_IO_REPORT_COUNT; i++) {
+        bool subscribed =
+            conn != NULL && bt_gatt_is_subscribed(conn, input_report_attrs[i], BT_GATT_CCC_NOTIFY);
+        atomic_set_bit_to(&subscribed_reports, i, subscribed);
+    }
+}
+
+static inline struct hog_report_buf *hog_report_queue_head(struct hog_report_queue *q) {
+    sys_snode_t *node = sys_slist_peek_head(&q->list);
+    return node == NULL ? NULL : CONTAINER_OF(node, struct hog_report_buf, node);
+}
+
+static inline struct hog_report_buf *hog_report_queue_newest(struct hog_report_queue *q) {
+    sys_snode_t *node = sys_slist_peek_tail(&q->list);
+    return node == NULL ? NULL : CONTAINER_OF(node, struct hog_report_buf, node);
+}
+
+static inline struct hog_report_buf *hog_report_queue_next(struct hog_report_buf *buf) {
+    sys_snode_t *node = sys_slist_peek_next(&buf->node);
+    return node == NULL ? NULL : CONTAINER_OF(node, struct hog_report_buf, node);
+}
+
+static inline bool hog_report_coalesce(const struct zmk_hid_io_report_def *def) {
+    return IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_COALESCE_REPORTS) &&
+           def->policy == ZMK_HID_IO_REPORT_POLICY_RELATIVE;
+}
+
+// True if `report` changes the button state of `prev`. Absolute reports are all state.
+static bool hog_report_is_transition(const struct zmk_hid_io_report_def *def, const void *prev,
+                                     const void *report) {
+    if (def->policy != ZMK_HID_IO_REPORT_POLICY_RELATIVE) {
+        return true;
+    }
+    return !def->mergeable(prev, report);
+}
+
+/*
+ * Make room by removing the oldest pure-motion report. Its motion is folded into a
+ * neighbour with the same button state where there is one, otherwise `lost` is set.
+ * Returns the freed block, or NULL if only transitions are queued. Must be called with
+ * the queue lock held.
+ */
+static struct hog_report_buf *hog_report_queue_evict_motion(const struct zmk_hid_io_report_def *def,
+                                                            struct hog_report_queue *q,
+                                                            bool *lost) {
+    struct hog_report_buf *prev = NULL;
+
+    for (struct hog_report_buf *buf = hog_report_queue_head(q); buf != NULL;
+         prev = buf, buf = hog_report_queue_next(buf)) {
+        if (buf->transition) {
+            continue;
         }
-        default:
-            LOG_WRN("Failed to queue joystick report to send (%d)", err);
-            return err;
+
+        struct hog_report_buf *next = hog_report_queue_next(buf);
+        *lost = false;
+        if (prev != NULL) {
+            def->merge(prev->body, buf->body);
+        } else if (next != NULL && !next->transition) {
+            def->merge(next->body, buf->body);
+            next->stamp = MIN(next->stamp, buf->stamp);
+        } else {
+            *lost = true;
         }
+
+        sys_slist_remove(&q->list, prev != NULL ? &prev->node : NULL, &buf->node);
+        q->count--;
+        return buf;
     }
 
-    k_work_submit_to_queue(&hog_alt_work_q, &hog_alt_joystick_work);
+    return NULL;
+}
 
-    return 0;
-};
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+/*
+ * Take a block for a transition while the shared pool is used up, possibly by other
+ * usages: the oldest pure-motion report queued for any usage makes room, its motion folded
+ * as on eviction. Returns NULL if every queue holds only transitions.
+ */
+static struct hog_report_buf *hog_report_pool_reclaim(void) {
+    struct hog_report_queue *oldest = NULL;
+    int64_t oldest_stamp = INT64_MAX;
+    size_t oldest_index = 0;
+
+    for (size_t i = 0; i < ZMK_HID_IO_REPORT_COUNT; i++) {
+        struct hog_report_queue *q = &hog_report_queues[i];
+
+        k_spinlock_key_t key = k_spin_lock(&q->lock);
+        for (struct hog_report_buf *buf = hog_report_queue_head(q); buf != NULL;
+             buf = hog_report_queue_next(buf)) {
+            if (!buf->transition) {
+                if (buf->stamp < oldest_stamp) {
+                    oldest = q;
+                    oldest_stamp = buf->stamp;
+                    oldest_index = i;
+                }
+                break;
+            }
+        }
+        k_spin_unlock(&q->lock, key);
+    }
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    if (oldest == NULL) {
+        return NULL;
+    }
 
-K_MSGQ_DEFINE(zmk_hog_mouse_alt_msgq, sizeof(struct zmk_hid_mouse_report_body_alt),
-              CONFIG_ZMK_HID_IO_BLE_MOUSE_REPORT_QUEUE_SIZE, 4);
+    const struct zmk_hid_io_report_def *def = zmk_hid_io_reports[oldest_index];
+    bool lost = false;
 
-void send_mouse_report_alt_callback(struct k_work *work) {
-    struct zmk_hid_mouse_report_body_alt report;
-    while (k_msgq_get(&zmk_hog_mouse_alt_msgq, &report, K_NO_WAIT) == 0) {
-        struct bt_conn *conn = destination_connection_alt();
-        if (conn == NULL) {
-            return;
-        }
+    k_spinlock_key_t key = k_spin_lock(&oldest->lock);
+    struct hog_report_buf *buf = hog_report_queue_evict_motion(def, oldest, &lost);
+    k_spin_unlock(&oldest->lock, key);
+
+    if (lost) {
+        LOG_WRN("HOG report %d motion dropped to make room for a transition", def->id);
+    }
 
-        struct bt_gatt_notify_params notify_params = {
-            .attr = &hog_svc_alt.attrs[ bt_gatt_char_offset_mouse ],
-            .data = &report,
-            .len = sizeof(report),
-        };
-
-        int err = bt_gatt_notify_cb(conn, &notify_params);
-        if (err == -EPERM) {
-            bt_conn_set_security(conn, BT_SECURITY_L2);
-        } else if (err) {
-            LOG_DBG("Error notifying %d", err);
+    return buf;
+}
+
+/*
+ * Queue the current body of a report. Reports are classified by content: transitions
+ * change the button state and are never dropped, pure motion may be merged or dropped.
+ * With coalescing enabled, motion is merged into the newest queued report, so a new block
+ * is only consumed on button changes. When the queue or the shared pool is full, the
+ * oldest pure-motion report makes room and its motion is folded into a neighbour with the
+ * same button state; if only transitions are queued, new motion is folded into the newest.
+ * A transition finding the pool used up by other usages takes the block of the oldest
+ * motion queued anywhere. Never waits: blocks are taken from the shared pool with
+ * K_NO_WAIT and the queue lock only covers list updates bounded by the queue capacity.
+ */
+static int hog_report_queue_put(const struct zmk_hid_io_report_def *def) {
+    struct hog_report_queue *q = &hog_report_queues[def->index];
+    const void *report = ZMK_HID_IO_REPORT_BODY(def);
+    struct hog_report_buf *buf = NULL;
+    struct hog_report_buf *released = NULL;
+    struct hog_report_buf *newest;
+    void *block;
+    bool lost = false;
+    int err = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&q->lock);
+    const bool transition = hog_report_is_transition(def, q->last, report);
+    newest = hog_report_queue_newest(q);
+    if (!transition && newest != NULL && hog_report_coalesce(def)) {
+        // the stamp stays, so a block absorbing motion still ages with its oldest motion
+        def->merge(newest->body, report);
+        k_spin_unlock(&q->lock, key);
+        return 0;
+    }
+    if (newest != NULL && (def->policy == ZMK_HID_IO_REPORT_POLICY_LATEST ||
+                           (def->policy == ZMK_HID_IO_REPORT_POLICY_FIFO &&
+                            atomic_get(&hog_alt_security_pending)))) {
+        // absolute state not sent yet, or held for security elevation: only the latest
+        // value matters
+        memcpy(newest->body, report, def->body_size);
+        memcpy(q->last, report, def->body_size);
+        k_spin_unlock(&q->lock, key);
+        return 0;
+    }
+    k_spin_unlock(&q->lock, key);
+
+    if (k_mem_slab_alloc(&hog_alt_report_slab, &block, K_NO_WAIT) == 0) {
+        buf = block;
+    } else if (transition) {
+        buf = hog_report_pool_reclaim();
+    }
+
+    key = k_spin_lock(&q->lock);
+
+    if (q->count == q->capacity || (buf == NULL && q->count > 0)) {
+        struct hog_report_buf *evicted = hog_report_queue_evict_motion(def, q, &lost);
+        if (evicted == NULL && !transition && q->count > 0) {
+            // only transitions queued; the newest one carries the same button state
+            def->merge(hog_report_queue_newest(q)->body, report);
+            released = buf;
+            buf = NULL;
+        } else if (evicted == NULL) {
+            err = -ENOBUFS;
+        } else if (buf == NULL) {
+            buf = evicted;
+        } else {
+            released = evicted;
         }
+    }
 
-        bt_conn_unref(conn);
+    if (err == 0 && buf != NULL) {
+        memcpy(buf->body, report, def->body_size);
+        buf->transition = transition;
+        buf->stamp = k_uptime_get();
+        sys_slist_append(&q->list, &buf->node);
+        q->count++;
+        memcpy(q->last, report, def->body_size);
+    } else if (err == 0 && released == NULL) {
+        err = -ENOMEM;
     }
-};
 
-K_WORK_DEFINE(hog_alt_mouse_work, send_mouse_report_alt_callback);
+    k_spin_unlock(&q->lock, key);
+
+    if (released != NULL) {
+        hog_alt_report_buf_free(released);
+    }
 
-int zmk_hog_send_mouse_report_alt(struct zmk_hid_mouse_report_body_alt *report) {
-    int err = k_msgq_put(&zmk_hog_mouse_alt_msgq, report, K_MSEC(100));
     if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("mouse message queue full, popping first message and queueing again");
-            struct zmk_hid_mouse_report_body_alt discarded_report;
-            k_msgq_get(&zmk_hog_mouse_alt_msgq, &discarded_report, K_NO_WAIT);
-            return zmk_hog_send_mouse_report_alt(report);
-        }
-        default:
-            LOG_WRN("Failed to queue mouse report to send (%d)", err);
-            return err;
+        if (buf != NULL) {
+            hog_alt_report_buf_free(buf);
         }
+        LOG_ERR("No room to queue HOG report %d transition (%d)", def->id, err);
+        return err;
     }
 
-    k_work_submit_to_queue(&hog_alt_work_q, &hog_alt_mouse_work);
+    if (lost) {
+        LOG_WRN("HOG report %d queue full, dropped motion", def->id);
+    }
 
     return 0;
-};
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+}
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+/*
+ * Put a report that could not be sent back at the head of the queue. If producers filled
+ * the queue in the meantime, a pure-motion report makes room for it; a latest-wins report
+ * superseded in the meantime is simply dropped.
+ */
+static void hog_report_queue_unget(const struct zmk_hid_io_report_def *def,
+                                   struct hog_report_buf *buf) {
+    struct hog_report_queue *q = &hog_report_queues[def->index];
+    struct hog_report_buf *evicted = NULL;
+    struct hog_report_buf *release = NULL;
+    bool lost = false;
+
+    k_spinlock_key_t key = k_spin_lock(&q->lock);
+    if (q->count == q->capacity && def->policy == ZMK_HID_IO_REPORT_POLICY_RELATIVE) {
+        evicted = hog_report_queue_evict_motion(def, q, &lost);
+    }
+    if (q->count < q->capacity) {
+        sys_slist_prepend(&q->list, &buf->node);
+        q->count++;
+    } else {
+        release = buf;
+        lost = buf->transition && def->policy == ZMK_HID_IO_REPORT_POLICY_RELATIVE;
+    }
+    k_spin_unlock(&q->lock, key);
 
-K_MSGQ_DEFINE(zmk_hog_volume_knob_alt_msgq, sizeof(struct zmk_hid_volume_knob_report_body_alt),
-              CONFIG_ZMK_HID_IO_BLE_VOLUME_KNOB_REPORT_QUEUE_SIZE, 4);
+    if (evicted != NULL) {
+        hog_alt_report_buf_free(evicted);
+    }
+    if (release != NULL) {
+        hog_alt_report_buf_free(release);
+    }
+    if (lost) {
+        LOG_WRN("HOG report %d queue full, dropped a report", def->id);
+    }
+}
 
-void send_volume_knob_report_alt_callback(struct k_work *work) {
-    struct zmk_hid_volume_knob_report_body_alt report;
-    while (k_msgq_get(&zmk_hog_volume_knob_alt_msgq, &report, K_NO_WAIT) == 0) {
-        struct bt_conn *conn = destination_connection_alt();
-        if (conn == NULL) {
-            return;
+/*
+ * Expire pure-motion reports at the head of the queue that are older than the queue's
+ * deadline: fold them into the next report of the same button state, or discard them.
+ */
+static void hog_report_queue_expire(const struct zmk_hid_io_report_def *def,
+                                    struct hog_report_queue *q) {
+    if (q->deadline_ms == 0) {
+        return;
+    }
+
+    const int64_t now = k_uptime_get();
+    for (;;) {
+        struct hog_report_buf *expired = NULL;
+
+        k_spinlock_key_t key = k_spin_lock(&q->lock);
+        struct hog_report_buf *head = hog_report_queue_head(q);
+        if (head != NULL && !head->transition && now - head->stamp > q->deadline_ms) {
+            struct hog_report_buf *next = hog_report_queue_next(head);
+            if (IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_EXPIRED_MOTION_DISCARD)) {
+                expired = head;
+            } else if (next != NULL && !next->transition) {
+                def->merge(next->body, head->body);
+                next->stamp = MIN(next->stamp, head->stamp);
+                expired = head;
+            }
+            if (expired != NULL) {
+                sys_slist_get(&q->list);
+                q->count--;
+            }
         }
+        k_spin_unlock(&q->lock, key);
 
-        struct bt_gatt_notify_params notify_params = {
-            .attr = &hog_svc_alt.attrs[ bt_gatt_char_offset_volume_knob ],
-            .data = &report,
-            .len = sizeof(report),
-        };
-
-        int err = bt_gatt_notify_cb(conn, &notify_params);
-        if (err == -EPERM) {
-            bt_conn_set_security(conn, BT_SECURITY_L2);
-        } else if (err) {
-            LOG_DBG("Error notifying %d", err);
+        if (expired == NULL) {
+            return;
         }
+        hog_alt_report_buf_free(expired);
+    }
+}
 
-        bt_conn_unref(conn);
+// Take the head report; with `transitions_only`, only if it is a transition.
+static struct hog_report_buf *hog_report_queue_get(struct hog_report_queue *q,
+                                                   bool transitions_only) {
+    struct hog_report_buf *buf;
+
+    k_spinlock_key_t key = k_spin_lock(&q->lock);
+    buf = hog_report_queue_head(q);
+    if (buf != NULL && (!transitions_only || buf->transition)) {
+        sys_slist_get(&q->list);
+        q->count--;
+    } else {
+        buf = NULL;
     }
-};
+    k_spin_unlock(&q->lock, key);
 
-K_WORK_DEFINE(hog_alt_volume_knob_work, send_volume_knob_report_alt_callback);
+    return buf;
+}
 
-int zmk_hog_send_volume_knob_report_alt(struct zmk_hid_volume_knob_report_body_alt *report) {
-    int err = k_msgq_put(&zmk_hog_volume_knob_alt_msgq, report, K_MSEC(100));
-    if (err) {
-        switch (err) {
-        case -EAGAIN: {
-            LOG_WRN("volume_knob message queue full, popping first message and queueing again");
-            struct zmk_hid_volume_knob_report_body_alt discarded_report;
-            k_msgq_get(&zmk_hog_volume_knob_alt_msgq, &discarded_report, K_NO_WAIT);
-            return zmk_hog_send_volume_knob_report_alt(report);
+/*
+ * Notify one report taken from its queue, with a notify credit already taken. Once the
+ * stack took the notification the report is released. On failure the credit is returned.
+ * -EAGAIN means sending has to stop until security elevation or a notify completion; the
+ * report is then left to the caller to put back, so reports taken together can be put
+ * back in order. On other errors the report is dropped.
+ */
+static int hog_alt_notify(struct bt_conn *conn, const struct zmk_hid_io_report_def *def,
+                          struct hog_report_buf *buf) {
+    /*
+     * Every notification has the same completion callback and user data, which lets the
+     * stack pack the ones of a round into a single Multiple Handle Value Notification
+     * when that is enabled and the peer supports it.
+     */
+    struct bt_gatt_notify_params notify_params = {
+        .attr = input_report_attrs[def->index],
+        .data = buf->body,
+        .len = def->body_size,
+        .func = hog_alt_notify_complete,
+        .user_data = hog_alt_notify_gen_get(),
+    };
+
+    int err = bt_gatt_notify_cb(conn, &notify_params);
+    if (err == 0) {
+        hog_alt_report_buf_free(buf);
+        return 0;
+    }
+
+    hog_alt_give_notify_credit();
+
+    if (err == -EPERM && bt_conn_get_security(conn) < BT_SECURITY_L2) {
+        // hold the report until the link is encrypted instead of losing it
+        if (atomic_cas(&hog_alt_security_pending, 0, 1)) {
+            int sec_err = bt_conn_set_security(conn, BT_SECURITY_L2);
+            if (sec_err) {
+                LOG_WRN("Failed to request security elevation (%d)", sec_err);
+                atomic_clear(&hog_alt_security_pending);
+            }
         }
-        default:
-            LOG_WRN("Failed to queue volume_knob report to send (%d)", err);
-            return err;
+        return -EAGAIN;
+    }
+
+    if (err == -ENOMEM || err == -ENOBUFS) {
+        // keep the report; resume from the next completion, or retry shortly if none
+        if (atomic_get(&hog_alt_notify_credits) >= CONFIG_ZMK_HID_IO_BLE_NOTIFY_WINDOW) {
+            k_work_schedule_for_queue(HOG_ALT_WORK_Q, &hog_alt_retry_work,
+                                      K_MSEC(HOG_ALT_NOTIFY_RETRY_MS));
         }
+        return -EAGAIN;
     }
 
-    k_work_submit_to_queue(&hog_alt_work_q, &hog_alt_volume_knob_work);
+    hog_alt_report_buf_free(buf);
+    LOG_DBG("Error notifying report %d: %d", def->id, err);
+    return err;
+}
 
-    return 0;
+// Reports taken from their queues in one send round, each holding a notify credit.
+struct hog_notify_round {
+    size_t count;
+    struct {
+        const struct zmk_hid_io_report_def *def;
+        struct hog_report_buf *buf;
+    } entries[CONFIG_ZMK_HID_IO_BLE_NOTIFY_WINDOW];
 };
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-
-static int zmk_hog_init(void) {
 
-    for (size_t i = 0; i < hog_svc_alt.attr_count; i++) {
-        // scan the cb from output of BT_GATT_CHARACTERISTIC() macros,
-        // each output inserts 2 elements into attrs array, so we minus one the offset.
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_NOTIFY_MULTIPLE)
+// Notify the reports of a round back to back, so the stack can pack them into one PDU.
+// Returns -EAGAIN if sending has to stop.
+static int hog_notify_round_send(struct bt_conn *conn, struct hog_notify_round *round) {
+    int ret = 0;
+
+    size_t i = 0;
+    for (; i < round->count; i++) {
+        int err = hog_alt_notify(conn, round->entries[i].def, round->entries[i].buf);
+        if (err == -EAGAIN) {
+            ret = -EAGAIN;
+            break;
+        }
+    }
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-        if (hog_svc_alt.attrs[i].read == read_hids_joystick_input_report) {
-            bt_gatt_char_offset_joystick = i - 1;
+    /*
+     * Put back the report that failed and all after it, newest first so each queue keeps
+     * its order. The failed one already returned its credit.
+     */
+    for (size_t j = round->count; j > i; j--) {
+        if (j - 1 > i) {
+            hog_alt_give_notify_credit();
         }
+        hog_report_queue_unget(round->entries[j - 1].def, round->entries[j - 1].buf);
+    }
+    round->count = 0;
+
+    return ret;
+}
 #endif
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-        if (hog_svc_alt.attrs[i].read == read_hids_mouse_input_report) {
-            bt_gatt_char_offset_mouse = i - 1;
+/*
+ * Send up to `quota` reports of one queue, or add them to `round` to be notified
+ * together. Returns the number of reports taken from the queue, or -EAGAIN if sending has
+ * to stop until security elevation or a notify completion.
+ */
+static int hog_report_queue_drain(struct bt_conn *conn, const struct zmk_hid_io_report_def *def,
+                                  bool transitions_only, int quota,
+                                  struct hog_notify_round *round) {
+    struct hog_report_queue *q = &hog_report_queues[def->index];
+    struct hog_report_buf *buf;
+    int taken = 0;
+
+    hog_report_queue_expire(def, q);
+
+    for (; taken < quota; taken++) {
+        if (!hog_alt_take_notify_credit()) {
+            return -EAGAIN;
+        }
+        buf = hog_report_queue_get(q, transitions_only);
+        if (buf == NULL) {
+            hog_alt_give_notify_credit();
+            break;
+        }
+
+        if (!zmk_hog_report_subscribed_alt(def)) {
+            hog_alt_report_buf_free(buf);
+            hog_alt_give_notify_credit();
+            continue;
+        }
+
+        if (round != NULL) {
+            // bounded by the notify credits
+            round->entries[round->count].def = def;
+            round->entries[round->count].buf = buf;
+            round->count++;
+            continue;
+        }
+
+        if (hog_alt_notify(conn, def, buf) == -EAGAIN) {
+            hog_report_queue_unget(def, buf);
+            return -EAGAIN;
         }
+    }
+
+    return taken;
+}
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_WORK_QUEUE_STACK_STATS)
+static size_t hog_alt_stack_high_water;
+
+static void hog_alt_log_stack_usage(void) {
+    k_tid_t thread = k_work_queue_thread_get(HOG_ALT_WORK_Q);
+    size_t unused;
+
+    if (k_thread_stack_space_get(thread, &unused) != 0) {
+        return;
+    }
+
+    size_t used = thread->stack_info.size - unused;
+    if (used > hog_alt_stack_high_water) {
+        hog_alt_stack_high_water = used;
+        LOG_INF("HOG send work queue stack high-water %zu of %zu bytes", used,
+                thread->stack_info.size);
+    }
+}
 #endif
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-        if (hog_svc_alt.attrs[i].read == read_hids_volume_knob_input_report) {
-            bt_gatt_char_offset_volume_knob = i - 1;
+// Report the next send pass starts with, so no usage is always served last.
+static size_t hog_alt_next_report;
+
+static void send_report_alt_callback(struct k_work *work) {
+    if (atomic_get(&hog_alt_security_pending)) {
+        return;
+    }
+
+    struct bt_conn *conn = destination_connection_alt();
+    if (conn == NULL) {
+        return;
+    }
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_LINK_MANAGER)
+    zmk_hid_io_link_activity(conn);
+#endif
+
+    /*
+     * Button transitions of every report go first, then the remaining motion; each
+     * report's own queue keeps its order. Within a class, reports are served round-robin
+     * with at most CONFIG_ZMK_HID_IO_BLE_SEND_QUANTUM per report and round, so a flood on
+     * one usage cannot starve the others.
+     */
+    struct hog_notify_round round_buf = {0};
+    struct hog_notify_round *round =
+        IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_NOTIFY_MULTIPLE) ? &round_buf : NULL;
+    bool blocked = false;
+    for (int pass = 0; pass < 2 && !blocked; pass++) {
+        bool progress = true;
+        while (progress && !blocked) {
+            progress = false;
+            for (size_t n = 0; n < ZMK_HID_IO_REPORT_COUNT && !blocked; n++) {
+                size_t i = (hog_alt_next_report + n) % ZMK_HID_IO_REPORT_COUNT;
+                int taken = hog_report_queue_drain(conn, zmk_hid_io_reports[i], pass == 0,
+                                                   CONFIG_ZMK_HID_IO_BLE_SEND_QUANTUM, round);
+                if (taken < 0) {
+                    hog_alt_next_report = (i + 1) % ZMK_HID_IO_REPORT_COUNT;
+                    blocked = true;
+                }
+                progress |= taken > 0;
+            }
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_NOTIFY_MULTIPLE)
+            // one PDU per round for the reports of all usages
+            if (hog_notify_round_send(conn, round) < 0) {
+                blocked = true;
+            }
+#endif
         }
+    }
+
+    bt_conn_unref(conn);
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_WORK_QUEUE_STACK_STATS)
+    hog_alt_log_stack_usage();
 #endif
+}
 
+K_WORK_DEFINE(hog_alt_send_work, send_report_alt_callback);
+
+int zmk_hog_send_report_alt(const struct zmk_hid_io_report_def *def) {
+    int err = hog_report_queue_put(def);
+    if (err) {
+        LOG_WRN("Failed to queue report %d to send (%d)", def->id, err);
+        return err;
     }
 
+    k_work_submit_to_queue(HOG_ALT_WORK_Q, &hog_alt_send_work);
+
+    return 0;
+}
+
+void zmk_hog_discard_reports_alt(void) {
+    for (size_t i = 0; i < ZMK_HID_IO_REPORT_COUNT; i++) {
+        struct hog_report_queue *q = &hog_report_queues[i];
+        sys_slist_t stale;
+        sys_snode_t *node;
+
+        k_spinlock_key_t key = k_spin_lock(&q->lock);
+        stale = q->list;
+        sys_slist_init(&q->list);
+        q->count = 0;
+        // the next report is classified against an empty state, not a dropped one
+        memset(q->last, 0, sizeof(q->last));
+        k_spin_unlock(&q->lock, key);
+
+        while ((node = sys_slist_get(&stale)) != NULL) {
+            hog_alt_report_buf_free(CONTAINER_OF(node, struct hog_report_buf, node));
+        }
+    }
+}
+
+static void hog_alt_resume_send(void) {
+    k_work_submit_to_queue(HOG_ALT_WORK_Q, &hog_alt_send_work);
+}
+
+// Notifications in flight on a lost link never complete: take their credits back.
+static void hog_alt_notify_link_lost(void) {
+    k_work_submit_to_queue(HOG_ALT_WORK_Q, &hog_alt_reset_credits_work);
+}
+
+static int zmk_hog_init(void) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_WORK_QUEUE_DEDICATED)
     static const struct k_work_queue_config queue_config = {.name = "HID Over GATT Send Work"};
     k_work_queue_start(&hog_alt_work_q, hog_alt_q_stack, K_THREAD_STACK_SIZEOF(hog_alt_q_stack),
                        CONFIG_ZMK_BLE_THREAD_PRIORITY, &queue_config);
+#endif
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_BLE_WORK_QUEUE_STACK_STATS)
+    LOG_INF("HOG sends on the %s work queue, %d bytes of RAM saved", HOG_ALT_WORK_Q_NAME,
+            HOG_ALT_WORK_Q_RAM_SAVED);
+#endif
 
     return 0;
 }
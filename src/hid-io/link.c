@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
+
+#include <zmk/hid-io/link.h>
+#include <zmk/hid-io/link_policy.h>
+
+/*
+ * Activity-aware link manager: while HID I/O reports flow, the link is asked for the
+ * shortest connection interval, 2M PHY and maximum data length. Once idle, the connection
+ * parameters the link had before are requested again; PHY and data length are kept, as
+ * they cost nothing while no data is exchanged.
+ */
+
+// Guarded by link_lock; link_state.conn holds its own reference.
+static struct zmk_hid_io_link_state link_state;
+static struct k_spinlock link_lock;
+
+static struct bt_conn *link_conn_get(void) {
+    struct bt_conn *conn = NULL;
+
+    k_spinlock_key_t key = k_spin_lock(&link_lock);
+    if (link_state.conn != NULL) {
+        conn = bt_conn_ref(link_state.conn);
+    }
+    k_spin_unlock(&link_lock, key);
+
+    return conn;
+}
+
+static void link_boost_work_cb(struct k_work *work) {
+    struct bt_conn *conn = link_conn_get();
+    struct bt_conn_info info;
+    int err;
+
+    if (conn == NULL) {
+        return;
+    }
+
+    if (bt_conn_get_info(conn, &info) == 0 && zmk_hid_io_link_is_slow(info.le.interval)) {
+        err = bt_conn_le_param_update(conn,
+                                      BT_LE_CONN_PARAM(CONFIG_ZMK_HID_IO_BLE_LINK_FAST_INTERVAL_MIN,
+                                                       CONFIG_ZMK_HID_IO_BLE_LINK_FAST_INTERVAL_MAX,
+                                                       0, CONFIG_ZMK_HID_IO_BLE_LINK_FAST_TIMEOUT));
+        if (err) {
+            LOG_WRN("Failed to request fast connection parameters (%d)", err);
+        } else {
+            const struct zmk_hid_io_link_param idle_param = {
+                .interval = info.le.interval,
+                .latency = info.le.latency,
+                .timeout = info.le.timeout,
+            };
+            k_spinlock_key_t key = k_spin_lock(&link_lock);
+            zmk_hid_io_link_state_boosted(&link_state, conn, &idle_param);
+            k_spin_unlock(&link_lock, key);
+        }
+    }
+
+#if IS_ENABLED(CONFIG_BT_USER_PHY_UPDATE)
+    err = bt_conn_le_phy_update(conn, BT_CONN_LE_PHY_PARAM_2M);
+    if (err) {
+        LOG_DBG("Failed to request 2M PHY (%d)", err);
+    }
+#endif
+
+#if IS_ENABLED(CONFIG_BT_USER_DATA_LEN_UPDATE)
+    err = bt_conn_le_data_len_update(conn, BT_LE_DATA_LEN_PARAM_MAX);
+    if (err) {
+        LOG_DBG("Failed to request data length extension (%d)", err);
+    }
+#endif
+
+    bt_conn_unref(conn);
+}
+
+static K_WORK_DEFINE(link_boost_work, link_boost_work_cb);
+
+static void link_idle_work_cb(struct k_work *work) {
+    struct zmk_hid_io_link_param param;
+    bool restore;
+
+    k_spinlock_key_t key = k_spin_lock(&link_lock);
+    struct bt_conn *conn = zmk_hid_io_link_state_idle(&link_state, &restore, &param);
+    k_spin_unlock(&link_lock, key);
+
+    if (conn == NULL) {
+        return;
+    }
+
+    if (restore) {
+        int err = bt_conn_le_param_update(
+            conn, BT_LE_CONN_PARAM(param.interval, param.interval, param.latency, param.timeout));
+        if (err) {
+            LOG_WRN("Failed to relax connection parameters (%d)", err);
+        }
+    }
+
+    bt_conn_unref(conn);
+}
+
+static K_WORK_DELAYABLE_DEFINE(link_idle_work, link_idle_work_cb);
+
+void zmk_hid_io_link_activity(struct bt_conn *conn) {
+    struct bt_conn *old;
+
+    k_spinlock_key_t key = k_spin_lock(&link_lock);
+    bool boost = zmk_hid_io_link_state_activity(&link_state, conn, &old);
+    if (boost) {
+        bt_conn_ref(conn);
+    }
+    k_spin_unlock(&link_lock, key);
+
+    if (old != NULL) {
+        bt_conn_unref(old);
+    }
+    if (boost) {
+        k_work_submit(&link_boost_work);
+    }
+
+    k_work_reschedule(&link_idle_work, K_MSEC(CONFIG_ZMK_HID_IO_BLE_LINK_IDLE_TIMEOUT_MS));
+}
+
+static void link_disconnected(struct bt_conn *conn, uint8_t reason) {
+    k_spinlock_key_t key = k_spin_lock(&link_lock);
+    struct bt_conn *old = zmk_hid_io_link_state_disconnected(&link_state, conn);
+    k_spin_unlock(&link_lock, key);
+
+    if (old != NULL) {
+        bt_conn_unref(old);
+    }
+}
+
+static void link_param_updated(struct bt_conn *conn, uint16_t interval, uint16_t latency,
+                               uint16_t timeout) {
+    LOG_DBG("Connection interval %u, latency %u, timeout %u", interval, latency, timeout);
+}
+
+BT_CONN_CB_DEFINE(link_conn_callbacks) = {
+    .disconnected = link_disconnected,
+    .le_param_updated = link_param_updated,
+};
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stddef.h>
+
+#include <zmk/hid-io/link_policy.h>
+
+bool zmk_hid_io_link_is_slow(uint16_t interval) {
+    return interval > CONFIG_ZMK_HID_IO_BLE_LINK_FAST_INTERVAL_MAX;
+}
+
+bool zmk_hid_io_link_state_activity(struct zmk_hid_io_link_state *state, struct bt_conn *conn,
+                                    struct bt_conn **old) {
+    *old = NULL;
+    if (state->conn == conn) {
+        return false;
+    }
+
+    *old = state->conn;
+    state->conn = conn;
+    state->restore = false;
+    return true;
+}
+
+void zmk_hid_io_link_state_boosted(struct zmk_hid_io_link_state *state, struct bt_conn *conn,
+                                   const struct zmk_hid_io_link_param *param) {
+    if (state->conn != conn) {
+        return;
+    }
+
+    state->idle_param = *param;
+    state->restore = true;
+}
+
+struct bt_conn *zmk_hid_io_link_state_idle(struct zmk_hid_io_link_state *state, bool *restore,
+                                           struct zmk_hid_io_link_param *param) {
+    struct bt_conn *conn = state->conn;
+
+    *restore = conn != NULL && state->restore;
+    *param = state->idle_param;
+
+    state->conn = NULL;
+    state->restore = false;
+    return conn;
+}
+
+struct bt_conn *zmk_hid_io_link_state_disconnected(struct zmk_hid_io_link_state *state,
+                                                   struct bt_conn *conn) {
+    if (state->conn != conn) {
+        return NULL;
+    }
+
+    state->conn = NULL;
+    state->restore = false;
+    return conn;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
+
+#include <string.h>
+
+#include <zephyr/sys/barrier.h>
+
+#include <zmk/hid-io/report.h>
+
+static K_MUTEX_DEFINE(reports_lock);
+// Keeps snapshot writes short and non-preemptible, see zmk_hid_io_report_publish().
+static struct k_spinlock snapshot_lock;
+
+// Report IDs come from devicetree, so catch collisions here rather than in reports_by_id. The
+// IDs of all usages are checked, enabled or not.
+BUILD_ASSERT(ZMK_HID_IO_JOYSTICK_REPORT_ID != ZMK_HID_IO_MOUSE_REPORT_ID &&
+                 ZMK_HID_IO_JOYSTICK_REPORT_ID != ZMK_HID_IO_OUTPUT_REPORT_ID &&
+                 ZMK_HID_IO_JOYSTICK_REPORT_ID != ZMK_HID_IO_VOLUME_KNOB_REPORT_ID &&
+                 ZMK_HID_IO_MOUSE_REPORT_ID != ZMK_HID_IO_OUTPUT_REPORT_ID &&
+                 ZMK_HID_IO_MOUSE_REPORT_ID != ZMK_HID_IO_VOLUME_KNOB_REPORT_ID &&
+                 ZMK_HID_IO_OUTPUT_REPORT_ID != ZMK_HID_IO_VOLUME_KNOB_REPORT_ID,
+             "HID I/O report IDs must be distinct");
+BUILD_ASSERT(IN_RANGE(ZMK_HID_IO_JOYSTICK_REPORT_ID, 1, UINT8_MAX) &&
+                 IN_RANGE(ZMK_HID_IO_MOUSE_REPORT_ID, 1, UINT8_MAX) &&
+                 IN_RANGE(ZMK_HID_IO_OUTPUT_REPORT_ID, 1, UINT8_MAX) &&
+                 IN_RANGE(ZMK_HID_IO_VOLUME_KNOB_REPORT_ID, 1, UINT8_MAX),
+             "HID I/O report IDs must be 1 to 255");
+
+const struct zmk_hid_io_report_def *const zmk_hid_io_reports[ZMK_HID_IO_REPORT_COUNT] = {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    [ZMK_HID_IO_REPORT_JOYSTICK] = &zmk_hid_io_report_def_joystick,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    [ZMK_HID_IO_REPORT_MOUSE] = &zmk_hid_io_report_def_mouse,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+    [ZMK_HID_IO_REPORT_VOLUME_KNOB] = &zmk_hid_io_report_def_volume_knob,
+#endif
+};
+
+static const struct zmk_hid_io_report_def *const reports_by_id[ZMK_HID_IO_REPORT_ID_MAX + 1] = {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    [ZMK_HID_REPORT_ID__IO_JOYSTICK] = &zmk_hid_io_report_def_joystick,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    [ZMK_HID_REPORT_ID__IO_MOUSE] = &zmk_hid_io_report_def_mouse,
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+    [ZMK_HID_REPORT_ID__IO_VOLUME_KNOB] = &zmk_hid_io_report_def_volume_knob,
+#endif
+};
+
+const struct zmk_hid_io_report_def *zmk_hid_io_report_get(uint8_t report_id) {
+    if (report_id > ZMK_HID_IO_REPORT_ID_MAX) {
+        return NULL;
+    }
+    return reports_by_id[report_id];
+}
+
+bool zmk_hid_io_report_changed(const struct zmk_hid_io_report_def *def) {
+    const uint8_t *body = ZMK_HID_IO_REPORT_BODY(def);
+
+    if (def->policy == ZMK_HID_IO_REPORT_POLICY_RELATIVE && !def->idle(body)) {
+        return true;
+    }
+    return memcmp(body, def->last_sent, def->body_size) != 0;
+}
+
+void zmk_hid_io_report_mark_sent(const struct zmk_hid_io_report_def *def) {
+    memcpy(def->last_sent, ZMK_HID_IO_REPORT_BODY(def), def->body_size);
+}
+
+void zmk_hid_io_report_publish(const struct zmk_hid_io_report_def *def) {
+    struct zmk_hid_io_report_snapshot *snap = def->snapshot;
+
+    /*
+     * A single writer, under the report lock. Readers run in the BT RX and USB threads and
+     * retry while the counter is odd: keep the writer from being preempted meanwhile, or a
+     * higher priority reader on the same core would spin forever. On SMP the lock also
+     * bounds the wait of a reader on another core to this copy.
+     */
+    k_spinlock_key_t key = k_spin_lock(&snapshot_lock);
+    atomic_inc(&snap->seq);
+    barrier_dmem_fence_full();
+    memcpy(&snap->report, def->report, ZMK_HID_IO_REPORT_SIZE(def));
+    barrier_dmem_fence_full();
+    atomic_inc(&snap->seq);
+    k_spin_unlock(&snapshot_lock, key);
+}
+
+void zmk_hid_io_report_read(const struct zmk_hid_io_report_def *def, void *report) {
+    struct zmk_hid_io_report_snapshot *snap = def->snapshot;
+    atomic_val_t seq;
+
+    do {
+        seq = atomic_get(&snap->seq);
+        barrier_dmem_fence_full();
+        memcpy(report, &snap->report, ZMK_HID_IO_REPORT_SIZE(def));
+        barrier_dmem_fence_full();
+    } while ((seq & 1) || atomic_get(&snap->seq) != seq);
+}
+
+void zmk_hid_io_report_lock(void) { k_mutex_lock(&reports_lock, K_FOREVER); }
+
+void zmk_hid_io_report_unlock(void) { k_mutex_unlock(&reports_lock); }
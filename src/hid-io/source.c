@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/kernel.h>
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
+
+#include <zmk/hid-io/endpoints.h>
+#include <zmk/hid-io/hid.h>
+#include <zmk/hid-io/report.h>
+#include <zmk/hid-io/source.h>
+
+static sys_slist_t sources = SYS_SLIST_STATIC_INIT(&sources);
+static uint8_t source_counts[ZMK_HID_IO_REPORT_COUNT];
+// Bit per report index with at least one pending contribution.
+static uint32_t pending_reports;
+
+// Serialises contributions, which touch the pending slots of all sources. Send cycles
+// are serialised by the report lock.
+static K_MUTEX_DEFINE(sources_lock);
+
+BUILD_ASSERT(ZMK_HID_IO_REPORT_COUNT <= 32, "pending_reports holds one bit per report");
+
+// Contributions of all sources of a report, merged for one send cycle.
+struct source_cycle {
+    int32_t x, y, scroll_x, scroll_y;
+    uint32_t press, release;
+    bool abs_pending;
+    int16_t abs_x, abs_y;
+    // motion beyond the range of the report was left with its sources
+    bool carried;
+};
+
+// Per-cycle range of the motion and wheel fields of a report.
+struct source_limits {
+    int32_t motion, scroll;
+};
+
+static struct source_limits source_limits_of(const struct zmk_hid_io_report_def *def) {
+    switch (def->id) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    case ZMK_HID_REPORT_ID__IO_JOYSTICK:
+        // no wheel, its motion is taken and ignored
+        return (struct source_limits){ZMK_HID_IO_JOYSTICK_AXIS_MAX, INT32_MAX};
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    case ZMK_HID_REPORT_ID__IO_MOUSE:
+        return (struct source_limits){ZMK_HID_IO_MOUSE_AXIS_MAX, ZMK_HID_IO_MOUSE_WHEEL_MAX};
+#endif
+    default:
+        return (struct source_limits){INT32_MAX, INT32_MAX};
+    }
+}
+
+#define SOURCE_SLOT(src, offset) ((int32_t *)((uint8_t *)(src) + (offset)))
+
+/*
+ * Take one motion field of the pending sources of a report, at most `limit` in total.
+ * Opposite motion of different sources cancels first; what still does not fit is left in
+ * the slots of the sources that moved in its direction, for a later cycle. Must be called
+ * with sources_lock held.
+ */
+static int32_t source_take_motion(const struct zmk_hid_io_report_def *def, size_t offset,
+                                  int32_t limit) {
+    struct zmk_hid_io_source *src;
+    int64_t sum = 0;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&sources, src, node) {
+        if (src->def == def && src->pending) {
+            sum += *SOURCE_SLOT(src, offset);
+        }
+    }
+
+    int32_t taken = (int32_t)CLAMP(sum, -limit, limit);
+    int64_t rest = sum - taken;
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&sources, src, node) {
+        if (src->def != def || !src->pending) {
+            continue;
+        }
+        int32_t *slot = SOURCE_SLOT(src, offset);
+        int32_t keep = (int32_t)(rest > 0 ? CLAMP(*slot, 0, rest) : CLAMP(*slot, rest, 0));
+        *slot = keep;
+        rest -= keep;
+    }
+
+    return taken;
+}
+
+/*
+ * Take the pending contributions of all sources of a report. Returns false if none is
+ * pending. Must be called with sources_lock held.
+ */
+static bool source_collect(const struct zmk_hid_io_report_def *def, struct source_cycle *cycle) {
+    const struct source_limits limits = source_limits_of(def);
+    struct zmk_hid_io_source *src;
+
+    if (!(pending_reports & BIT(def->index))) {
+        return false;
+    }
+    WRITE_BIT(pending_reports, def->index, false);
+
+    *cycle = (struct source_cycle){
+        .x = source_take_motion(def, offsetof(struct zmk_hid_io_source, x), limits.motion),
+        .y = source_take_motion(def, offsetof(struct zmk_hid_io_source, y), limits.motion),
+        .scroll_x =
+            source_take_motion(def, offsetof(struct zmk_hid_io_source, scroll_x), limits.scroll),
+        .scroll_y =
+            source_take_motion(def, offsetof(struct zmk_hid_io_source, scroll_y), limits.scroll),
+    };
+
+    SYS_SLIST_FOR_EACH_CONTAINER(&sources, src, node) {
+        if (src->def != def || !src->pending) {
+            continue;
+        }
+        // the press counts in the usage keep a button down while any source holds it
+        cycle->press |= src->press;
+        cycle->release |= src->release;
+        if (src->abs_pending) {
+            cycle->abs_pending = true;
+            cycle->abs_x = src->abs_x;
+            cycle->abs_y = src->abs_y;
+        }
+        src->press = src->release = 0;
+        src->abs_pending = false;
+        // motion that did not fit keeps the source pending
+        src->pending = src->x != 0 || src->y != 0 || src->scroll_x != 0 || src->scroll_y != 0;
+        cycle->carried |= src->pending;
+    }
+
+    if (cycle->carried) {
+        WRITE_BIT(pending_reports, def->index, true);
+    }
+
+    return true;
+}
+
+// Apply a merged cycle to the live report and send it. Must be called with the report lock
+// held.
+static void source_send_cycle(const struct zmk_hid_io_report_def *def,
+                              const struct source_cycle *cycle) {
+    switch (def->id) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+    case ZMK_HID_REPORT_ID__IO_JOYSTICK:
+        zmk_hid_joy2_movement_set(cycle->x, cycle->y);
+        zmk_hid_joy2_buttons_press(cycle->press);
+        zmk_hid_joy2_buttons_release(cycle->release);
+        zmk_endpoints_send_report_alt(def->id);
+        zmk_hid_joy2_movement_set(0, 0);
+        break;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
+    case ZMK_HID_REPORT_ID__IO_MOUSE:
+        zmk_hid_mou2_scroll_set(cycle->scroll_x, cycle->scroll_y);
+        zmk_hid_mou2_movement_set(cycle->x, cycle->y);
+        zmk_hid_mou2_buttons_press(cycle->press);
+        zmk_hid_mou2_buttons_release(cycle->release);
+        zmk_endpoints_send_report_alt(def->id);
+        zmk_hid_mou2_scroll_set(0, 0);
+        zmk_hid_mou2_movement_set(0, 0);
+        break;
+#endif
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
+    case ZMK_HID_REPORT_ID__IO_VOLUME_KNOB:
+        if (cycle->abs_pending) {
+            zmk_hid_volume_knob_vol_set(cycle->abs_y);
+        }
+        zmk_endpoints_send_report_alt(def->id);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    zmk_hid_io_report_publish(def);
+}
+
+static void source_cycle_work_cb(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(source_cycle_work, source_cycle_work_cb);
+
+// Delay of the cycle that sends motion carried over from a full report.
+static k_timeout_t source_residue_delay(void) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_FRAME_SCHEDULER)
+    return zmk_endpoints_frame_period_alt();
+#else
+    return K_NO_WAIT;
+#endif
+}
+
+/*
+ * Merge the pending contributions of all sources of a report into it and send it. The
+ * report lock is held across collecting and sending, so cycles go out in order; the
+ * sources lock only while collecting, so contributions never wait on a transport.
+ */
+static void source_flush(const struct zmk_hid_io_report_def *def) {
+    struct source_cycle cycle;
+
+    zmk_hid_io_report_lock();
+
+    k_mutex_lock(&sources_lock, K_FOREVER);
+    bool pending = source_collect(def, &cycle);
+    k_mutex_unlock(&sources_lock);
+
+    if (pending) {
+        source_send_cycle(def, &cycle);
+    }
+
+    if (pending && cycle.carried) {
+        // the rest goes out with the next cycle, one frame later
+        k_work_schedule(&source_cycle_work, source_residue_delay());
+    }
+
+    zmk_hid_io_report_unlock();
+}
+
+static void source_cycle_work_cb(struct k_work *work) {
+    k_mutex_lock(&sources_lock, K_FOREVER);
+    uint32_t pending = pending_reports;
+    k_mutex_unlock(&sources_lock);
+
+    for (size_t i = 0; i < ZMK_HID_IO_REPORT_COUNT; i++) {
+        if (pending & BIT(i)) {
+            source_flush(zmk_hid_io_reports[i]);
+        }
+    }
+}
+
+void zmk_hid_io_source_init(struct zmk_hid_io_source *src, uint8_t report_id) {
+    memset(src, 0, sizeof(*src));
+    src->def = zmk_hid_io_report_get(report_id);
+    if (src->def == NULL) {
+        return;
+    }
+
+    k_mutex_lock(&sources_lock, K_FOREVER);
+    sys_slist_append(&sources, &src->node);
+    source_counts[src->def->index]++;
+    k_mutex_unlock(&sources_lock);
+}
+
+int zmk_hid_io_source_contribute(struct zmk_hid_io_source *src,
+                                 const struct zmk_hid_io_contribution *contrib) {
+    const struct zmk_hid_io_report_def *def = src->def;
+    if (def == NULL) {
+        return -ENODEV;
+    }
+
+    k_mutex_lock(&sources_lock, K_FOREVER);
+
+    // a source only presses buttons it does not hold and releases buttons it holds
+    uint32_t press = contrib->button_set & ~src->buttons;
+    uint32_t release = contrib->button_clear & (src->buttons | press);
+
+    // a second transition of a button in one cycle would cancel the first: send it now
+    if ((press | release) & (src->press | src->release)) {
+        k_mutex_unlock(&sources_lock);
+        source_flush(def);
+        k_mutex_lock(&sources_lock, K_FOREVER);
+    }
+
+    src->buttons = (src->buttons | press) & ~release;
+    src->press |= press;
+    src->release |= release;
+
+    if (contrib->rel) {
+        src->x += contrib->x;
+        src->y += contrib->y;
+    }
+    if (contrib->abs) {
+        src->abs_pending = true;
+        src->abs_x = contrib->x;
+        src->abs_y = contrib->y;
+    }
+    if (contrib->scroll) {
+        src->scroll_x += contrib->scroll_x;
+        src->scroll_y += contrib->scroll_y;
+    }
+    src->pending = true;
+    WRITE_BIT(pending_reports, def->index, true);
+
+    // with a single source there is nothing to merge, skip the hop to the work queue
+    bool inline_send =
+        !IS_ENABLED(CONFIG_ZMK_HID_IO_ASYNC_SEND) && source_counts[def->index] <= 1;
+
+    k_mutex_unlock(&sources_lock);
+
+    if (inline_send) {
+        source_flush(def);
+    } else {
+        k_work_reschedule(&source_cycle_work, K_NO_WAIT);
+    }
+
+    return 0;
+}
@@ -14,8 +14,10 @@
 #include <zmk/hid.h>
 #include <zmk/keymap.h>
 #include <zmk/event_manager.h>
+#include <zmk/events/usb_conn_state_changed.h>
 
 #include <zmk/hid-io/hid.h>
+#include <zmk/hid-io/report.h>
 #include <zmk/hid-io/usb_hid.h>
 
 #include <zephyr/logging/log.h>
@@ -23,10 +25,212 @@ LOG_MODULE_DECLARE(hid_io, CONFIG_ZMK_HID_IO_LOG_LEVEL);
 
 static const struct device *hid_dev;
 
+// Published report handed to the host on GET_REPORT.
+static union zmk_hid_io_report_any get_report_buf;
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_USB_NONBLOCKING_SEND)
+
+// A transfer that has not completed after this long is considered lost (e.g. bus reset).
+#define USB_HID_IN_FLIGHT_TIMEOUT_MS 30
+
+struct usb_hid_pending_entry {
+    // changes the button state; motion-only entries are merged into their predecessor
+    bool transition;
+    union zmk_hid_io_report_any report;
+};
+
+struct usb_hid_pending_queue {
+    size_t head;
+    size_t count;
+    struct usb_hid_pending_entry entries[CONFIG_ZMK_HID_IO_USB_PENDING_DEPTH];
+    // newest report queued or written, to classify the next one
+    union zmk_hid_io_report_any last;
+};
+
+// Indexed by zmk_hid_io_report_def.index.
+static struct usb_hid_pending_queue pending_reports[ZMK_HID_IO_REPORT_COUNT];
+
+static struct k_spinlock hid_lock;
+static bool in_flight;
+static int64_t in_flight_since;
+static size_t next_pending;
+static union zmk_hid_io_report_any tx_report;
+
+static inline struct usb_hid_pending_entry *
+usb_hid_pending_entry(struct usb_hid_pending_queue *q, size_t idx) {
+    return &q->entries[(q->head + idx) % CONFIG_ZMK_HID_IO_USB_PENDING_DEPTH];
+}
+
+/*
+ * Make room by folding a motion-only report at the head into its successor. Motion is
+ * merged into the newest entry, so only the head can be motion-only. Returns false if
+ * every held report is a button transition. Must be called with hid_lock held.
+ */
+static bool usb_hid_evict_motion(const struct zmk_hid_io_report_def *def,
+                                 struct usb_hid_pending_queue *q) {
+    struct usb_hid_pending_entry *head = usb_hid_pending_entry(q, 0);
+
+    if (q->count < 2 || head->transition) {
+        return false;
+    }
+
+    def->merge((uint8_t *)&usb_hid_pending_entry(q, 1)->report + 1, (uint8_t *)&head->report + 1);
+    q->head = (q->head + 1) % CONFIG_ZMK_HID_IO_USB_PENDING_DEPTH;
+    q->count--;
+    return true;
+}
+
+/*
+ * Hold the live report until the IN endpoint is free. Relative motion is merged into the
+ * newest held report while the button state is unchanged, so button transitions each
+ * keep their own entry; absolute reports replace the held one. Once the queue holds
+ * nothing but transitions, a further one is merged into the newest entry, which loses the
+ * button state of that entry. Must be called with hid_lock held.
+ */
+static void usb_hid_store_pending(const struct zmk_hid_io_report_def *def) {
+    struct usb_hid_pending_queue *q = &pending_reports[def->index];
+    const uint8_t *body = ZMK_HID_IO_REPORT_BODY(def);
+    const bool relative = def->policy == ZMK_HID_IO_REPORT_POLICY_RELATIVE;
+    const bool transition = !relative || !def->mergeable((uint8_t *)&q->last + 1, body);
+
+    if (q->count > 0) {
+        struct usb_hid_pending_entry *newest = usb_hid_pending_entry(q, q->count - 1);
+        if (!transition) {
+            def->merge((uint8_t *)&newest->report + 1, body);
+            return;
+        }
+        if (relative && q->count == CONFIG_ZMK_HID_IO_USB_PENDING_DEPTH) {
+            usb_hid_evict_motion(def, q);
+        }
+        if (!relative || q->count == CONFIG_ZMK_HID_IO_USB_PENDING_DEPTH) {
+            union zmk_hid_io_report_any merged;
+            memcpy(&merged, def->report, ZMK_HID_IO_REPORT_SIZE(def));
+            if (relative) {
+                LOG_WRN("USB report %d pending queue full of button changes, one is lost",
+                        def->id);
+                def->merge((uint8_t *)&merged + 1, (uint8_t *)&newest->report + 1);
+            }
+            memcpy(&newest->report, &merged, ZMK_HID_IO_REPORT_SIZE(def));
+            memcpy(&q->last, &merged, ZMK_HID_IO_REPORT_SIZE(def));
+            return;
+        }
+    }
+
+    struct usb_hid_pending_entry *entry = usb_hid_pending_entry(q, q->count);
+    entry->transition = transition;
+    memcpy(&entry->report, def->report, ZMK_HID_IO_REPORT_SIZE(def));
+    memcpy(&q->last, def->report, ZMK_HID_IO_REPORT_SIZE(def));
+    q->count++;
+}
+
+// Move the oldest held report of a queue to the tx buffer. Must be called with hid_lock held.
+static size_t usb_hid_take_pending(size_t idx) {
+    struct usb_hid_pending_queue *q = &pending_reports[idx];
+    size_t len = ZMK_HID_IO_REPORT_SIZE(zmk_hid_io_reports[idx]);
+
+    memcpy(&tx_report, &usb_hid_pending_entry(q, 0)->report, len);
+    q->head = (q->head + 1) % CONFIG_ZMK_HID_IO_USB_PENDING_DEPTH;
+    q->count--;
+
+    return len;
+}
+
+static void usb_hid_reset_pending(void) {
+    k_spinlock_key_t key = k_spin_lock(&hid_lock);
+    in_flight = false;
+    // the host forgets the report state on a bus reset
+    memset(pending_reports, 0, sizeof(pending_reports));
+    k_spin_unlock(&hid_lock, key);
+}
+
+// Write the tx buffer. Must be called with in_flight claimed by the caller.
+static int usb_hid_write_tx_report(size_t len) {
+    LOG_HEXDUMP_DBG((uint8_t *)&tx_report, len, "HID-IO HID report");
+    int err = hid_int_ep_write(hid_dev, (uint8_t *)&tx_report, len, NULL);
+    if (err) {
+        k_spinlock_key_t key = k_spin_lock(&hid_lock);
+        in_flight = false;
+        k_spin_unlock(&hid_lock, key);
+    }
+    return err;
+}
+
+/*
+ * Send the next held report once the endpoint is free: button transitions of any report
+ * ID first, then motion, round-robin across report IDs.
+ */
+static void usb_hid_flush_pending(struct k_work *work) {
+    size_t len = 0;
+
+    if (zmk_usb_get_status() == USB_DC_SUSPEND) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&hid_lock);
+    for (int pass = 0; pass < 2 && !in_flight; pass++) {
+        for (size_t n = 0; n < ZMK_HID_IO_REPORT_COUNT; n++) {
+            size_t idx = (next_pending + n) % ZMK_HID_IO_REPORT_COUNT;
+            struct usb_hid_pending_queue *q = &pending_reports[idx];
+            if (q->count == 0 || (pass == 0 && !usb_hid_pending_entry(q, 0)->transition)) {
+                continue;
+            }
+            len = usb_hid_take_pending(idx);
+            next_pending = (idx + 1) % ZMK_HID_IO_REPORT_COUNT;
+            in_flight = true;
+            in_flight_since = k_uptime_get();
+            break;
+        }
+    }
+    k_spin_unlock(&hid_lock, key);
+
+    if (len > 0) {
+        usb_hid_write_tx_report(len);
+    }
+}
+
+static K_WORK_DEFINE(hid_flush_work, usb_hid_flush_pending);
+
+static void in_ready_cb(const struct device *dev) {
+    k_spinlock_key_t key = k_spin_lock(&hid_lock);
+    in_flight = false;
+    k_spin_unlock(&hid_lock, key);
+
+    k_work_submit(&hid_flush_work);
+}
+
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_USB_WAKE_PENDING)
+
+// Deliver the reports held during suspend as soon as the host has resumed the bus.
+static int usb_hid_alt_listener(const zmk_event_t *eh) {
+    if (as_zmk_usb_conn_state_changed(eh) == NULL) {
+        return ZMK_EV_EVENT_BUBBLE;
+    }
+
+    switch (zmk_usb_get_status()) {
+    case USB_DC_CONFIGURED:
+    case USB_DC_RESUME:
+        k_work_submit(&hid_flush_work);
+        break;
+    default:
+        break;
+    }
+
+    return ZMK_EV_EVENT_BUBBLE;
+}
+
+ZMK_LISTENER(usb_hid_alt, usb_hid_alt_listener);
+ZMK_SUBSCRIPTION(usb_hid_alt, zmk_usb_conn_state_changed);
+
+#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_USB_WAKE_PENDING)
+
+#else
+
 static K_SEM_DEFINE(hid_sem, 1, 1);
 
 static void in_ready_cb(const struct device *dev) { k_sem_give(&hid_sem); }
 
+#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_USB_NONBLOCKING_SEND)
+
 #define HID_GET_REPORT_TYPE_MASK 0xff00
 #define HID_GET_REPORT_ID_MASK 0x00ff
 
@@ -48,36 +252,18 @@ static int get_report_cb(const struct device *dev, struct usb_setup_packet *setu
         return -ENOTSUP;
     }
 
-    switch (setup->wValue & HID_GET_REPORT_ID_MASK) {
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-    case ZMK_HID_REPORT_ID__IO_JOYSTICK: {
-        struct zmk_hid_joystick_report_alt *report = zmk_hid_get_joystick_report_alt();
-        *data = (uint8_t *)report;
-        *len = sizeof(*report);
-        break;
-    }
-#endif
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-    case ZMK_HID_REPORT_ID__IO_MOUSE: {
-        struct zmk_hid_mouse_report_alt *report = zmk_hid_get_mouse_report_alt();
-        *data = (uint8_t *)report;
-        *len = sizeof(*report);
-        break;
-    }
-#endif
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-    case ZMK_HID_REPORT_ID__IO_VOLUME_KNOB: {
-        struct zmk_hid_volume_knob_report_alt *report = zmk_hid_get_volume_knob_report_alt();
-        *data = (uint8_t *)report;
-        *len = sizeof(*report);
-        break;
-    }
-#endif
-    default:
+    const struct zmk_hid_io_report_def *def =
+        zmk_hid_io_report_get(setup->wValue & HID_GET_REPORT_ID_MASK);
+    if (def == NULL) {
         LOG_ERR("[# hid-io #] Invalid report ID %d requested", setup->wValue & HID_GET_REPORT_ID_MASK);
         return -EINVAL;
     }
 
+    // the stack sends from *data after we return, so it must not point into the live report
+    zmk_hid_io_report_read(def, &get_report_buf);
+    *data = (uint8_t *)&get_report_buf;
+    *len = ZMK_HID_IO_REPORT_SIZE(def);
+
     return 0;
 }
 
@@ -113,16 +299,88 @@ static int set_report_cb(const struct device *dev, struct usb_setup_packet *setu
     return 0;
 }
 
+/*
+ * Wake the host for a report that is not kept across the suspend. -EAGAIN tells the caller
+ * the report was not sent, so it is not marked sent and an equal report still goes out.
+ */
+static int usb_hid_wakeup_unsent(void) {
+    int err = usb_wakeup_request();
+    return err ? err : -EAGAIN;
+}
+
 static const struct hid_ops ops = {
     .int_in_ready = in_ready_cb,
     .get_report = get_report_cb,
     .set_report = set_report_cb,
 };
 
-static int zmk_usb_hid_send_report_alt(const uint8_t *report, size_t len) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_USB_NONBLOCKING_SEND)
+
+/*
+ * Never blocks: if a transfer is in flight, the report is merged into the pending slot
+ * of its report ID and sent from in_ready_cb once the IN endpoint is free again.
+ */
+int zmk_usb_hid_send_report_alt(const struct zmk_hid_io_report_def *def) {
+    struct usb_hid_pending_queue *q = &pending_reports[def->index];
+    size_t len = ZMK_HID_IO_REPORT_SIZE(def);
+    k_spinlock_key_t key;
+
     switch (zmk_usb_get_status()) {
     case USB_DC_SUSPEND:
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_USB_WAKE_PENDING)
+        // keep the report that wakes the host; it is sent once the bus has resumed
+        key = k_spin_lock(&hid_lock);
+        usb_hid_store_pending(def);
+        in_flight = false;
+        k_spin_unlock(&hid_lock, key);
         return usb_wakeup_request();
+#else
+        return usb_hid_wakeup_unsent();
+#endif
+    case USB_DC_ERROR:
+    case USB_DC_RESET:
+    case USB_DC_DISCONNECTED:
+    case USB_DC_UNKNOWN:
+        usb_hid_reset_pending();
+        return -ENODEV;
+    default:
+        break;
+    }
+
+    key = k_spin_lock(&hid_lock);
+
+    if (in_flight && k_uptime_get() - in_flight_since > USB_HID_IN_FLIGHT_TIMEOUT_MS) {
+        in_flight = false;
+    }
+
+    if (in_flight) {
+        usb_hid_store_pending(def);
+        k_spin_unlock(&hid_lock, key);
+        return 0;
+    }
+
+    if (q->count > 0) {
+        // older held reports of this ID go first, in order
+        usb_hid_store_pending(def);
+        usb_hid_take_pending(def->index);
+    } else {
+        memcpy(&tx_report, def->report, len);
+        memcpy(&q->last, def->report, len);
+    }
+    in_flight = true;
+    in_flight_since = k_uptime_get();
+
+    k_spin_unlock(&hid_lock, key);
+
+    return usb_hid_write_tx_report(len);
+}
+
+#else
+
+int zmk_usb_hid_send_report_alt(const struct zmk_hid_io_report_def *def) {
+    switch (zmk_usb_get_status()) {
+    case USB_DC_SUSPEND:
+        return usb_hid_wakeup_unsent();
     case USB_DC_ERROR:
     case USB_DC_RESET:
     case USB_DC_DISCONNECTED:
@@ -130,8 +388,8 @@ static int zmk_usb_hid_send_report_alt(const uint8_t *report, size_t len) {
         return -ENODEV;
     default:
         k_sem_take(&hid_sem, K_MSEC(30));
-        LOG_HEXDUMP_DBG(report, len, "HID-IO HID report");
-        int err = hid_int_ep_write(hid_dev, report, len, NULL);
+        LOG_HEXDUMP_DBG(def->report, ZMK_HID_IO_REPORT_SIZE(def), "HID-IO HID report");
+        int err = hid_int_ep_write(hid_dev, def->report, ZMK_HID_IO_REPORT_SIZE(def), NULL);
 
         if (err) {
             k_sem_give(&hid_sem);
@@ -141,26 +399,20 @@ static int zmk_usb_hid_send_report_alt(const uint8_t *report, size_t len) {
     }
 }
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
-int zmk_usb_hid_send_joystick_report_alt() {
-    struct zmk_hid_joystick_report_alt *report = zmk_hid_get_joystick_report_alt();
-    return zmk_usb_hid_send_report_alt((uint8_t *)report, sizeof(*report));
-}
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_JOYSTICK)
+#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_USB_NONBLOCKING_SEND)
 
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-int zmk_usb_hid_send_mouse_report_alt() {
-    struct zmk_hid_mouse_report_alt *report = zmk_hid_get_mouse_report_alt();
-    return zmk_usb_hid_send_report_alt((uint8_t *)report, sizeof(*report));
-}
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_MOUSE)
-
-#if IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
-int zmk_usb_hid_send_volume_knob_report_alt() {
-    struct zmk_hid_volume_knob_report_alt *report = zmk_hid_get_volume_knob_report_alt();
-    return zmk_usb_hid_send_report_alt((uint8_t *)report, sizeof(*report));
+void zmk_usb_hid_discard_reports_alt(void) {
+#if IS_ENABLED(CONFIG_ZMK_HID_IO_USB_NONBLOCKING_SEND)
+    k_spinlock_key_t key = k_spin_lock(&hid_lock);
+    for (size_t i = 0; i < ZMK_HID_IO_REPORT_COUNT; i++) {
+        pending_reports[i].head = 0;
+        pending_reports[i].count = 0;
+        // the next report is classified against an empty state, not a dropped one
+        memset(&pending_reports[i].last, 0, sizeof(pending_reports[i].last));
+    }
+    k_spin_unlock(&hid_lock, key);
+#endif
 }
-#endif // IS_ENABLED(CONFIG_ZMK_HID_IO_VOLUME_KNOB)
 
 static int zmk_usb_hid_init_alt(void) {
     hid_dev = device_get_binding("HID_1");
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2024 The ZMK Contributors
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <zephyr/ztest.h>
+
+#include <zmk/hid-io/link_policy.h>
+
+// The policy only compares connections, stand-ins are enough.
+static uint8_t conn_objs[2];
+#define CONN_A ((struct bt_conn *)&conn_objs[0])
+#define CONN_B ((struct bt_conn *)&conn_objs[1])
+
+static const struct zmk_hid_io_link_param slow_param = {
+    .interval = 24,
+    .latency = 30,
+    .timeout = 400,
+};
+
+static struct zmk_hid_io_link_state state;
+
+static void link_before(void *fixture) { state = (struct zmk_hid_io_link_state){0}; }
+
+ZTEST_SUITE(hid_io_link, NULL, NULL, link_before, NULL, NULL);
+
+ZTEST(hid_io_link, test_only_slower_interval_is_sped_up) {
+    zassert_false(zmk_hid_io_link_is_slow(6));
+    zassert_false(zmk_hid_io_link_is_slow(9), "interval at the fast maximum is kept");
+    zassert_true(zmk_hid_io_link_is_slow(10));
+    zassert_true(zmk_hid_io_link_is_slow(slow_param.interval));
+}
+
+ZTEST(hid_io_link, test_first_activity_requests_fast_link) {
+    struct bt_conn *old;
+
+    zassert_true(zmk_hid_io_link_state_activity(&state, CONN_A, &old));
+    zassert_is_null(old);
+    zassert_equal_ptr(state.conn, CONN_A);
+
+    zassert_false(zmk_hid_io_link_state_activity(&state, CONN_A, &old),
+                  "ongoing activity must not request again");
+    zassert_is_null(old);
+}
+
+ZTEST(hid_io_link, test_idle_restores_saved_param) {
+    struct zmk_hid_io_link_param param;
+    struct bt_conn *old;
+    bool restore;
+
+    zmk_hid_io_link_state_activity(&state, CONN_A, &old);
+    zmk_hid_io_link_state_boosted(&state, CONN_A, &slow_param);
+
+    zassert_equal_ptr(zmk_hid_io_link_state_idle(&state, &restore, &param), CONN_A);
+    zassert_true(restore);
+    zassert_equal(param.interval, slow_param.interval);
+    zassert_equal(param.latency, slow_param.latency);
+    zassert_equal(param.timeout, slow_param.timeout);
+
+    zassert_is_null(zmk_hid_io_link_state_idle(&state, &restore, &param),
+                    "an idle link is relaxed once");
+    zassert_false(restore);
+}
+
+ZTEST(hid_io_link, test_idle_without_boost_keeps_param) {
+    struct zmk_hid_io_link_param param;
+    struct bt_conn *old;
+    bool restore;
+
+    // the link was already fast, nothing was requested or saved
+    zmk_hid_io_link_state_activity(&state, CONN_A, &old);
+
+    zassert_equal_ptr(zmk_hid_io_link_state_idle(&state, &restore, &param), CONN_A);
+    zassert_false(restore);
+}
+
+ZTEST(hid_io_link, test_activity_after_idle_requests_again) {
+    struct zmk_hid_io_link_param param;
+    struct bt_conn *old;
+    bool restore;
+
+    zmk_hid_io_link_state_activity(&state, CONN_A, &old);
+    zmk_hid_io_link_state_boosted(&state, CONN_A, &slow_param);
+    zmk_hid_io_link_state_idle(&state, &restore, &param);
+
+    zassert_true(zmk_hid_io_link_state_activity(&state, CONN_A, &old));
+    zassert_is_null(old);
+    zassert_false(state.restore, "parameters of the previous period must not be reused");
+}
+
+ZTEST(hid_io_link, test_switch_connection_drops_saved_param) {
+    struct zmk_hid_io_link_param param;
+    struct bt_conn *old;
+    bool restore;
+
+    zmk_hid_io_link_state_activity(&state, CONN_A, &old);
+    zmk_hid_io_link_state_boosted(&state, CONN_A, &slow_param);
+
+    zassert_true(zmk_hid_io_link_state_activity(&state, CONN_B, &old));
+    zassert_equal_ptr(old, CONN_A, "the previous connection is handed back to be released");
+
+    zassert_equal_ptr(zmk_hid_io_link_state_idle(&state, &restore, &param), CONN_B);
+    zassert_false(restore);
+}
+
+ZTEST(hid_io_link, test_late_boost_of_untracked_conn_is_ignored) {
+    struct zmk_hid_io_link_param param;
+    struct bt_conn *old;
+    bool restore;
+
+    zmk_hid_io_link_state_activity(&state, CONN_A, &old);
+    zmk_hid_io_link_state_activity(&state, CONN_B, &old);
+    zmk_hid_io_link_state_boosted(&state, CONN_A, &slow_param);
+
+    zmk_hid_io_link_state_idle(&state, &restore, &param);
+    zassert_false(restore);
+}
+
+ZTEST(hid_io_link, test_disconnect) {
+    struct zmk_hid_io_link_param param;
+    struct bt_conn *old;
+    bool restore;
+
+    zmk_hid_io_link_state_activity(&state, CONN_A, &old);
+    zmk_hid_io_link_state_boosted(&state, CONN_A, &slow_param);
+
+    zassert_is_null(zmk_hid_io_link_state_disconnected(&state, CONN_B),
+                    "other connections are not tracked");
+    zassert_equal_ptr(zmk_hid_io_link_state_disconnected(&state, CONN_A), CONN_A);
+
+    zassert_is_null(zmk_hid_io_link_state_idle(&state, &restore, &param));
+    zassert_false(restore, "a disconnected link is not relaxed");
+}